@@ -0,0 +1,267 @@
+/**
+ * Copyright by Ruman Gerst
+ * Research Group Applied Systems Biology - Head: Prof. Dr. Marc Thilo Figge
+ * https://www.leibniz-hki.de/en/applied-systems-biology.html
+ * HKI-Center for Systems Biology of Infection
+ * Leibniz Institute for Natural Product Research and Infection Biology - Hans Knöll Insitute (HKI)
+ * Adolf-Reichwein-Straße 23, 07745 Jena, Germany
+ *
+ * This code is licensed under BSD 2-Clause
+ * See the LICENSE file provided with this code for the full license.
+ */
+
+/**
+ * Measures the throughput of the OME TIFF read, write and conversion paths on synthetic data.
+ * Usage: misaxx-imaging-ome-bench [--output results.json] [--directory work-dir] [--max-threads N] [--planes N]
+ * The results are written as JSON to the output file (default: ome_tiff_io_benchmark.json).
+ * Stdout is not used, as the OME TIFF IO logs to it.
+ * Each configuration is measured with 1, 2, 4, ... threads and with the maximum number of threads.
+ */
+
+#include <misaxx/ome/misa_ome_tiff_description_builder.h>
+#include <misaxx/ome/utils/json_ome_pixel_type.h>
+#include <src/misaxx/ome/utils/ome_tiff_io.h>
+#include <src/misaxx/ome/utils/ome_to_ome.h>
+#include <src/misaxx/ome/utils/opencv_to_ome.h>
+#include <ome/files/MetadataTools.h>
+#include <ome/files/in/OMETIFFReader.h>
+#include <ome/files/out/OMETIFFWriter.h>
+#include <ome/common/log.h>
+#include <nlohmann/json.hpp>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+using namespace misaxx::ome;
+
+namespace {
+
+    struct benchmark_config {
+        int opencv_depth = CV_8U;
+        int channels = 1;
+        int plane_size = 512;
+        std::string compression = "none";
+        size_t num_planes = 16;
+
+        int get_opencv_type() const {
+            return CV_MAKETYPE(opencv_depth, channels);
+        }
+
+        size_t get_plane_bytes() const {
+            return static_cast<size_t>(plane_size) * plane_size * CV_ELEM_SIZE(get_opencv_type());
+        }
+
+        std::string get_name() const {
+            return std::to_string(opencv_depth) + "_" + std::to_string(channels) + "_" + std::to_string(plane_size) + "_" + compression;
+        }
+    };
+
+    struct benchmark_result {
+        std::string operation;
+        benchmark_config config;
+        size_t num_threads = 1;
+        double seconds = 0;
+
+        void to_json(nlohmann::json &t_json) const {
+            const double bytes = static_cast<double>(config.get_plane_bytes() * config.num_planes);
+            t_json["operation"] = operation;
+            t_json["pixel-type"] = opencv_depth_to_ome_pixel_type(config.opencv_depth);
+            t_json["channels"] = config.channels;
+            t_json["plane-size"] = config.plane_size;
+            t_json["compression"] = config.compression;
+            t_json["planes"] = config.num_planes;
+            t_json["threads"] = num_threads;
+            t_json["seconds"] = seconds;
+            t_json["planes-per-second"] = seconds > 0 ? config.num_planes / seconds : 0.0;
+            t_json["megabytes-per-second"] = seconds > 0 ? bytes / (1024.0 * 1024.0) / seconds : 0.0;
+        }
+    };
+
+    /**
+     * Measures the duration of a function in seconds
+     */
+    template<class Function> double measure(const Function &t_function) {
+        const auto start = std::chrono::steady_clock::now();
+        t_function();
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    /**
+     * Runs a function for each plane index. The planes are distributed over the threads.
+     */
+    template<class Function> void for_each_plane(size_t t_num_planes, size_t t_num_threads, const Function &t_function) {
+        std::vector<std::thread> threads;
+        for(size_t thread = 0; thread < t_num_threads; ++thread) {
+            threads.emplace_back([=, &t_function]() {
+                for(size_t plane = thread; plane < t_num_planes; plane += t_num_threads) {
+                    t_function(plane);
+                }
+            });
+        }
+        for(auto &thread : threads) {
+            thread.join();
+        }
+    }
+
+    /**
+     * Creates a plane with a smooth random pattern, so the compression behaves similar to microscopy data
+     */
+    cv::Mat create_plane(const benchmark_config &t_config, size_t t_index) {
+        cv::Mat result(t_config.plane_size, t_config.plane_size, t_config.get_opencv_type());
+        cv::RNG rng(static_cast<uint64_t>(t_index) + 1);
+        const double max_value = t_config.opencv_depth == CV_8U ? 255 : t_config.opencv_depth == CV_16U ? 65535 : 1;
+        rng.fill(result, cv::RNG::UNIFORM, 0, max_value);
+        cv::GaussianBlur(result, result, cv::Size(5, 5), 0);
+        return result;
+    }
+
+    std::shared_ptr<::ome::xml::meta::OMEXMLMetadata> create_metadata(const benchmark_config &t_config) {
+        misa_ome_tiff_description_builder builder { misa_ome_tiff_description() };
+        builder.of_size(t_config.plane_size, t_config.plane_size).of_opencv(t_config.get_opencv_type()).depth(t_config.num_planes);
+        return static_cast<misa_ome_tiff_description>(builder).metadata;
+    }
+
+    ome_tiff_compression parse_compression(const std::string &t_name) {
+        return ome_tiff_compression(ome_tiff_compression::parse_codec(t_name));
+    }
+
+    void run_benchmark(const benchmark_config &t_config, const boost::filesystem::path &t_directory, size_t t_num_threads,
+                       std::vector<benchmark_result> &t_results) {
+        const boost::filesystem::path path = t_directory / ("benchmark_" + t_config.get_name() + "_" + std::to_string(t_num_threads) + ".ome.tif");
+        boost::filesystem::remove(path);
+
+        std::vector<cv::Mat> planes;
+        for(size_t i = 0; i < t_config.num_planes; ++i) {
+            planes.emplace_back(create_plane(t_config, i));
+        }
+
+        // Write into the write buffer and assemble the OME TIFF
+        {
+            ome_tiff_io io(path, create_metadata(t_config));
+            io.set_compression(parse_compression(t_config.compression));
+            io.set_num_threads(t_num_threads);
+            t_results.push_back({ "write_plane", t_config, t_num_threads, measure([&]() {
+                for_each_plane(t_config.num_planes, t_num_threads, [&](size_t plane) {
+                    io.write_plane(planes[plane], misa_ome_plane_description(0, plane, 0, 0));
+                });
+            }) });
+            t_results.push_back({ "close", t_config, t_num_threads, measure([&]() {
+                io.close();
+            }) });
+        }
+
+        // Read the assembled OME TIFF
+        {
+            ome_tiff_io io(path);
+            io.get_metadata();
+            t_results.push_back({ "read_plane", t_config, t_num_threads, measure([&]() {
+                for_each_plane(t_config.num_planes, t_num_threads, [&](size_t plane) {
+                    io.read_plane(misa_ome_plane_description(0, plane, 0, 0));
+                });
+            }) });
+            io.close();
+        }
+
+        // Conversion between OME Files reader and writer is single-threaded
+        if(t_num_threads == 1) {
+            const boost::filesystem::path converted_path = t_directory / ("benchmark_" + t_config.get_name() + "_converted.ome.tif");
+            boost::filesystem::remove(converted_path);
+
+            ::ome::files::in::OMETIFFReader reader;
+            reader.setId(path);
+            auto metadata = std::static_pointer_cast<::ome::xml::meta::MetadataRetrieve>(::ome::files::createOMEXMLMetadata(path));
+            ::ome::files::out::OMETIFFWriter writer;
+            writer.setMetadataRetrieve(metadata);
+            writer.setBigTIFF(true);
+            writer.setId(converted_path);
+            t_results.push_back({ "ome_to_ome", t_config, t_num_threads, measure([&]() {
+                for(size_t plane = 0; plane < t_config.num_planes; ++plane) {
+                    const misa_ome_plane_description location(0, plane, 0, 0);
+                    ome_to_ome(reader, location, writer, location);
+                }
+                writer.close();
+            }) });
+            reader.close();
+            boost::filesystem::remove(converted_path);
+        }
+
+        boost::filesystem::remove(path);
+    }
+}
+
+int main(int argc, const char **argv) {
+    boost::filesystem::path output_path = "ome_tiff_io_benchmark.json";
+    boost::filesystem::path directory = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("misaxx-ome-bench-%%%%-%%%%");
+    size_t max_threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+    size_t num_planes = 16;
+
+    for(int i = 1; i + 1 < argc; i += 2) {
+        const std::string argument = argv[i];
+        if(argument == "--output")
+            output_path = argv[i + 1];
+        else if(argument == "--directory")
+            directory = argv[i + 1];
+        else if(argument == "--max-threads")
+            max_threads = std::max<size_t>(1, std::stoul(argv[i + 1]));
+        else if(argument == "--planes")
+            num_planes = std::max<size_t>(1, std::stoul(argv[i + 1]));
+        else {
+            std::cerr << "Unknown argument " << argument << "\n";
+            return 1;
+        }
+    }
+
+    ::ome::common::setLogLevel(::ome::logging::trivial::warning);
+    boost::filesystem::create_directories(directory);
+
+    std::vector<benchmark_config> configs;
+    for(int depth : { CV_8U, CV_16U, CV_32F }) {
+        for(int channels : { 1, 3 }) {
+            for(int plane_size : { 512, 2048 }) {
+                for(const std::string compression : { "none", "lzw", "deflate" }) {
+                    benchmark_config config;
+                    config.opencv_depth = depth;
+                    config.channels = channels;
+                    config.plane_size = plane_size;
+                    config.compression = compression;
+                    config.num_planes = num_planes;
+                    configs.push_back(config);
+                }
+            }
+        }
+    }
+
+    std::vector<size_t> thread_counts;
+    for(size_t num_threads = 1; num_threads < max_threads; num_threads *= 2) {
+        thread_counts.push_back(num_threads);
+    }
+    thread_counts.push_back(max_threads);
+
+    std::vector<benchmark_result> results;
+    for(const auto &config : configs) {
+        for(size_t num_threads : thread_counts) {
+            std::cerr << "[Benchmark] " << config.get_name() << " with " << num_threads << " threads" << "\n";
+            run_benchmark(config, directory, num_threads, results);
+        }
+    }
+    boost::filesystem::remove_all(directory);
+
+    nlohmann::json json;
+    json["max-threads"] = max_threads;
+    for(const auto &result : results) {
+        nlohmann::json entry;
+        result.to_json(entry);
+        json["results"].push_back(entry);
+    }
+
+    std::ofstream stream(output_path.string());
+    if(!stream) {
+        std::cerr << "Could not write the results to " << output_path << "\n";
+        return 1;
+    }
+    stream << json.dump(4) << "\n";
+    std::cerr << "[Benchmark] Results were written to " << output_path << "\n";
+    return 0;
+}
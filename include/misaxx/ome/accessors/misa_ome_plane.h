@@ -28,6 +28,30 @@ namespace misaxx::ome {
          */
         cv::Mat clone() const;
 
+        /**
+         * Copies the image stored in this OME TIFF plane into an existing cv::Mat.
+         * If the plane is not cached, it is decoded directly into the destination.
+         * @param t_dst Must have the size and type of the plane and can be a region of interest of a larger cv::Mat.
+         * If empty, it is allocated.
+         */
+        void read_into(cv::Mat &t_dst) const;
+
+        /**
+         * Reads a rectangular region of this OME TIFF plane.
+         * If the plane is not cached, only the parts of the TIFF that overlap with the region are decoded.
+         * @param t_region Region within the plane
+         * @return A copy of the region
+         */
+        cv::Mat read_region(const cv::Rect &t_region) const;
+
+        /**
+         * Reads a reduced resolution level of this OME TIFF plane. Each level halves the width and height of the previous level.
+         * If the plane is not cached, levels that are stored in the OME TIFF are read without decoding the full plane.
+         * @param t_level The level. Level 0 is the plane itself.
+         * @return A copy of the level
+         */
+        cv::Mat read_level(size_t t_level) const;
+
         /**
          * Writes data into this OME TIFF plane
          * @param t_cache
@@ -35,6 +59,14 @@ namespace misaxx::ome {
          */
         void write(cv::Mat t_data);
 
+        /**
+         * Returns true if data was written into this plane that is not stored in the OME TIFF yet.
+         * This includes planes that were restored from the write buffer of an interrupted run, which allows
+         * tasks to skip planes that were already produced.
+         * @return
+         */
+        bool is_buffered() const;
+
         /**
          * Returns the location of this plane within the TIFF file
          * @return
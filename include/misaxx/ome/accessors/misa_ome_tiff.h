@@ -45,6 +45,47 @@ namespace misaxx::ome {
 
         misa_ome_plane at(const misa_ome_plane_description &index);
 
+        /**
+         * Reads multiple planes at once. This is faster than reading the planes one by one,
+         * as the planes are read in the order they are stored and decoded in parallel.
+         * Please note that this accesses the OME TIFF directly and bypasses the plane caches.
+         * Modifications that were not written yet are not included.
+         * @param indices the planes
+         * @return The planes in the order of the indices
+         */
+        std::vector<cv::Mat> read_planes(const std::vector<misa_ome_plane_description> &indices) const;
+
+        /**
+         * Reads all planes of the depth axis at once
+         * Please note that this accesses the OME TIFF directly and bypasses the plane caches.
+         * Modifications that were not written yet are not included.
+         * @param series
+         * @param c location within the channel axis
+         * @param t location within the time axis
+         * @return The planes ordered by their depth
+         */
+        std::vector<cv::Mat> read_stack(size_t series = 0, size_t c = 0, size_t t = 0) const;
+
+        /**
+         * Reads all planes of the depth axis into one contiguous volume.
+         * Please note that this accesses the OME TIFF directly. Modifications that were not written yet are not included.
+         * @param series
+         * @param c location within the channel axis
+         * @param t location within the time axis
+         * @return A three-dimensional cv::Mat with the sizes Z, Y and X
+         */
+        cv::Mat read_volume(size_t series = 0, size_t c = 0, size_t t = 0) const;
+
+        /**
+         * Writes all planes of the depth axis from one contiguous volume.
+         * Please note that this writes directly into the OME TIFF.
+         * @param volume A three-dimensional cv::Mat with the sizes Z, Y and X
+         * @param series
+         * @param c location within the channel axis
+         * @param t location within the time axis
+         */
+        void write_volume(const cv::Mat &volume, size_t series = 0, size_t c = 0, size_t t = 0);
+
         /**
          * Width of each plane in the TIFF
          * @param series
@@ -15,6 +15,7 @@
 #include <misaxx/core/misa_manual_cache.h>
 #include <misaxx/core/utils/string.h>
 #include <opencv2/opencv.hpp>
+#include <mutex>
 #include <misaxx/core/misa_default_cache.h>
 #include <misaxx/ome/descriptions/misa_ome_plane_description.h>
 
@@ -25,12 +26,30 @@ namespace misaxx::ome {
     /**
      * Caches a plane within an OME TIFF file.
      * The plane is accessed via a misa_ome_plane_location that indicates where the 2D image data is located within the TIFF file.
+     *
+     * If a plane cache memory limit is set, planes that were read from the TIFF can be evicted by other plane caches.
+     * Evicted planes are read again on the next access.
+     * Planes are pinned while they cannot be evicted: get() pins the plane until it is pushed, stashed or pulled again,
+     * as the returned reference is used for the whole access. Planes that are referenced by another cv::Mat instance
+     * (for example the header returned by acquire()) or that were modified and not written yet are never evicted.
      */
     struct misa_ome_plane_cache : public misaxx::misa_manual_cache<misaxx::utils::cache<cv::Mat>, misa_ome_plane_description> {
+
+        misa_ome_plane_cache() = default;
+
+        ~misa_ome_plane_cache() override;
+
         cv::Mat &get() override;
 
         const cv::Mat &get() const override;
 
+        /**
+         * Returns a cv::Mat header that shares the cached image.
+         * The plane cannot be evicted while the header exists, so it does not pin the plane beyond its lifetime like get().
+         * @return
+         */
+        cv::Mat acquire() const;
+
         void set(cv::Mat value) override;
 
         bool has() const override;
@@ -60,6 +79,35 @@ namespace misaxx::ome {
 
     private:
         std::shared_ptr<ome_tiff_io> m_tiff;
-        cv::Mat m_cached_image;
+        mutable cv::Mat m_cached_image;
+        mutable std::mutex m_cached_image_mutex;
+
+        /**
+         * True if the cached image was evicted and needs to be read again. Guarded by m_cached_image_mutex.
+         */
+        mutable bool m_evicted = false;
+
+        /**
+         * True if get() handed out a reference to the cached image. Guarded by m_cached_image_mutex.
+         */
+        mutable bool m_pinned = false;
+
+        /**
+         * Reads the image again if it was evicted and marks the image as recently used
+         */
+        void restore() const;
+
+        /**
+         * Counts the cached image towards the plane cache memory limit
+         * @param t_evictable If false, the image is never evicted (for example if it cannot be read again)
+         */
+        void track(bool t_evictable = true) const;
+
+        /**
+         * Releases the cached image if it is not pinned and not referenced elsewhere.
+         * Called by the plane cache LRU from other caches, so the access lock of this cache is not used.
+         * @return
+         */
+        bool try_evict() const;
     };
 }
@@ -19,6 +19,8 @@
 #include <misaxx/core/misa_cached_data.h>
 #include <misaxx/ome/accessors/misa_ome_plane.h>
 #include <misaxx/core/misa_parameter.h>
+#include <atomic>
+#include <mutex>
 
 namespace misaxx::ome {
 
@@ -47,12 +49,26 @@ namespace misaxx::ome {
 
         /**
          * Returns the plane cache from a plane location
-         * @param t_cache
+         * The plane cache is created if it was not accessed before.
          * @param t_location
          * @return
          */
         misa_ome_plane get_plane(const misa_ome_plane_description &t_location) const;
 
+        /**
+         * Returns the plane cache at the index within the list of planes
+         * The plane cache is created if it was not accessed before.
+         * @param t_index
+         * @return
+         */
+        misa_ome_plane get_plane(size_t t_index) const;
+
+        /**
+         * Creates all plane caches that were not accessed yet.
+         * Required before the list of planes is iterated.
+         */
+        void link_all_planes() const;
+
         void postprocess() override;
 
     protected:
@@ -64,11 +80,61 @@ namespace misaxx::ome {
 
     private:
 
+        /**
+         * Location of the plane caches of a series within the plane cache list
+         */
+        struct series_plane_index {
+            size_t offset = 0;
+            size_t num_z = 0;
+            size_t num_c = 0;
+            size_t num_t = 0;
+        };
+
         std::shared_ptr<ome_tiff_io> m_tiff;
 
+        /**
+         * Plane index of each series. Created during linking, so get_plane does not need to query the metadata.
+         */
+        std::vector<series_plane_index> m_series_plane_index;
+
+        /**
+         * Plane caches are only created when they are accessed.
+         * Protects the creation of plane caches.
+         */
+        mutable std::mutex m_plane_mutex;
+        mutable std::atomic<bool> m_all_planes_linked { false };
+
+        /**
+         * Returns the location of the plane at the index within the list of planes
+         * @param t_index
+         * @return
+         */
+        misa_ome_plane_description get_plane_location(size_t t_index) const;
+
+        /**
+         * Creates the plane cache at the index if it does not exist. m_plane_mutex must be locked.
+         * @param t_index
+         */
+        void link_plane(size_t t_index) const;
+
         misaxx::misa_parameter<bool> m_remove_write_buffer_parameter;
         misaxx::misa_parameter<bool> m_disable_ome_tiff_writing_parameter;
         misaxx::misa_parameter<bool> m_enable_compression_parameter;
+        misaxx::misa_parameter<std::string> m_compression_codec_parameter;
+        misaxx::misa_parameter<int> m_compression_level_parameter;
+        misaxx::misa_parameter<bool> m_enable_compression_predictor_parameter;
+        misaxx::misa_parameter<bool> m_enable_direct_writing_parameter;
+        misaxx::misa_parameter<int> m_tile_size_parameter;
+        misaxx::misa_parameter<int> m_num_io_threads_parameter;
+        misaxx::misa_parameter<int> m_plane_cache_limit_parameter;
+        misaxx::misa_parameter<int> m_prefetch_depth_parameter;
+        misaxx::misa_parameter<int> m_prefetch_limit_parameter;
+        misaxx::misa_parameter<bool> m_enable_memory_mapping_parameter;
+        misaxx::misa_parameter<std::string> m_write_buffer_format_parameter;
+        misaxx::misa_parameter<bool> m_restore_write_buffer_parameter;
+        misaxx::misa_parameter<int> m_pyramid_levels_parameter;
+        misaxx::misa_parameter<bool> m_enable_io_statistics_parameter;
+        misaxx::misa_parameter<int> m_buffer_pool_limit_parameter;
 
     };
 }
\ No newline at end of file
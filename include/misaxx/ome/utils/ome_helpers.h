@@ -26,4 +26,27 @@ namespace misaxx::ome::helpers {
 
     extern std::shared_ptr<::ome::xml::meta::OMEXMLMetadata>
     create_ome_xml_metadata(size_t size_X, size_t size_Y, size_t size_Z, size_t size_T, std::vector<size_t> size_C, ::ome::xml::model::enums::PixelType pixel_type);
+
+    /**
+     * Returns the index of a plane within its series as it is stored in the OME TIFF.
+     * The index depends on the dimension order of the series.
+     * @param t_metadata
+     * @param series
+     * @param z
+     * @param c
+     * @param t
+     * @return
+     */
+    extern ::ome::files::dimension_size_type
+    get_plane_index(const ::ome::xml::meta::OMEXMLMetadata &t_metadata, size_t series, size_t z, size_t c, size_t t);
+
+    /**
+     * Inverse of get_plane_index. Returns the Z, C and T location of a plane index within a series.
+     * @param t_metadata
+     * @param series
+     * @param index
+     * @return
+     */
+    extern std::array<::ome::files::dimension_size_type, 3>
+    get_plane_zct(const ::ome::xml::meta::OMEXMLMetadata &t_metadata, size_t series, ::ome::files::dimension_size_type index);
 }
\ No newline at end of file
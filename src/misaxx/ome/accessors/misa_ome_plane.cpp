@@ -12,15 +12,57 @@
 
 #include <misaxx/ome/accessors/misa_ome_plane.h>
 #include "../utils/ome_tiff_io.h"
+#include "../utils/ome_tiff_pyramid.h"
 
 cv::Mat misaxx::ome::misa_ome_plane::clone() const {
-    return this->access_readonly().get().clone();
+    // The header keeps the plane from being evicted only while it is used
+    auto access = this->access_readonly();
+    return this->data->acquire().clone();
+}
+
+void misaxx::ome::misa_ome_plane::read_into(cv::Mat &t_dst) const {
+    if(this->data->has()) {
+        auto access = this->access_readonly();
+        const cv::Mat image = this->data->acquire();
+        if(!t_dst.empty() && (t_dst.size() != image.size() || t_dst.type() != image.type()))
+            throw std::runtime_error("The plane " + misaxx::utils::to_string(get_plane_location()) + " does not have the size and type of its destination!");
+        image.copyTo(t_dst);
+        return;
+    }
+    this->data->get_tiff_io()->read_plane(get_plane_location(), t_dst);
+}
+
+cv::Mat misaxx::ome::misa_ome_plane::read_region(const cv::Rect &t_region) const {
+    if(this->data->has()) {
+        auto access = this->access_readonly();
+        return this->data->acquire()(t_region).clone();
+    }
+    return this->data->get_tiff_io()->read_plane_region(get_plane_location(), t_region);
+}
+
+cv::Mat misaxx::ome::misa_ome_plane::read_level(size_t t_level) const {
+    if(this->data->has()) {
+        auto access = this->access_readonly();
+        const cv::Mat image = this->data->acquire();
+        if(t_level == 0)
+            return image.clone();
+        cv::Mat result = ome_tiff_downsample(image);
+        for(size_t i = 1; i < t_level; ++i) {
+            result = ome_tiff_downsample(result);
+        }
+        return result;
+    }
+    return this->data->get_tiff_io()->read_plane_level(get_plane_location(), t_level);
 }
 
 void misaxx::ome::misa_ome_plane::write(cv::Mat t_data) {
     this->access_write().set(std::move(t_data));
 }
 
+bool misaxx::ome::misa_ome_plane::is_buffered() const {
+    return this->data->get_tiff_io()->is_buffered(get_plane_location());
+}
+
 const misaxx::ome::misa_ome_plane_description &misaxx::ome::misa_ome_plane::get_plane_location() const {
     return this->data->get_plane_location();
 }
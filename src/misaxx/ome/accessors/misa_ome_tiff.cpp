@@ -14,6 +14,8 @@
 #include "../utils/ome_tiff_io.h"
 
 misaxx::ome::misa_ome_tiff::iterator misaxx::ome::misa_ome_tiff::begin() {
+    // Iteration requires all planes
+    this->data->link_all_planes();
     return this->data->get().begin();
 }
 
@@ -22,6 +24,8 @@ misaxx::ome::misa_ome_tiff::iterator misaxx::ome::misa_ome_tiff::end() {
 }
 
 misaxx::ome::misa_ome_tiff::const_iterator misaxx::ome::misa_ome_tiff::begin() const {
+    // Iteration requires all planes
+    this->data->link_all_planes();
     return this->data->get().begin();
 }
 
@@ -38,13 +42,34 @@ bool misaxx::ome::misa_ome_tiff::empty() const {
 }
 
 misaxx::ome::misa_ome_plane misaxx::ome::misa_ome_tiff::at(size_t index) const {
-    return this->data->get().at(index);
+    return this->data->get_plane(index);
 }
 
 misaxx::ome::misa_ome_plane misaxx::ome::misa_ome_tiff::at(const misaxx::ome::misa_ome_plane_description &index) {
     return this->data->get_plane(index);
 }
 
+std::vector<cv::Mat>
+misaxx::ome::misa_ome_tiff::read_planes(const std::vector<misaxx::ome::misa_ome_plane_description> &indices) const {
+    return this->data->get_tiff_io()->read_planes(indices);
+}
+
+std::vector<cv::Mat> misaxx::ome::misa_ome_tiff::read_stack(size_t series, size_t c, size_t t) const {
+    std::vector<misa_ome_plane_description> indices;
+    for(size_t z = 0; z < get_size_z(series); ++z) {
+        indices.emplace_back(series, z, c, t);
+    }
+    return read_planes(indices);
+}
+
+cv::Mat misaxx::ome::misa_ome_tiff::read_volume(size_t series, size_t c, size_t t) const {
+    return this->data->get_tiff_io()->read_volume(series, c, t);
+}
+
+void misaxx::ome::misa_ome_tiff::write_volume(const cv::Mat &volume, size_t series, size_t c, size_t t) {
+    this->data->get_tiff_io()->write_volume(volume, series, c, t);
+}
+
 size_t misaxx::ome::misa_ome_tiff::get_size_x(size_t series) const {
     return this->data->get_tiff_io()->get_size_x(series);
 }
@@ -13,21 +13,43 @@
 #include <misaxx/ome/caches/misa_ome_plane_cache.h>
 #include <misaxx/ome/attachments/misa_ome_planes_location.h>
 #include "../utils/ome_tiff_io.h"
+#include "../utils/ome_plane_lru.h"
+
+misaxx::ome::misa_ome_plane_cache::~misa_ome_plane_cache() {
+    ome_plane_lru::global().remove(this);
+}
 
 cv::Mat &misaxx::ome::misa_ome_plane_cache::get() {
+    restore();
+    std::lock_guard<std::mutex> lock(m_cached_image_mutex);
+    m_pinned = true;
     return m_cached_image;
 }
 
 const cv::Mat &misaxx::ome::misa_ome_plane_cache::get() const {
+    restore();
+    std::lock_guard<std::mutex> lock(m_cached_image_mutex);
+    m_pinned = true;
+    return m_cached_image;
+}
+
+cv::Mat misaxx::ome::misa_ome_plane_cache::acquire() const {
+    restore();
+    std::lock_guard<std::mutex> lock(m_cached_image_mutex);
     return m_cached_image;
 }
 
 void misaxx::ome::misa_ome_plane_cache::set(cv::Mat value) {
+    // Modified images are not allowed to be evicted until they are written
+    ome_plane_lru::global().remove(this);
+    std::lock_guard<std::mutex> lock(m_cached_image_mutex);
     m_cached_image = std::move(value);
+    m_evicted = false;
 }
 
 bool misaxx::ome::misa_ome_plane_cache::has() const {
-    return !m_cached_image.empty();
+    std::lock_guard<std::mutex> lock(m_cached_image_mutex);
+    return m_evicted || !m_cached_image.empty();
 }
 
 bool misaxx::ome::misa_ome_plane_cache::can_pull() const {
@@ -35,17 +57,77 @@ bool misaxx::ome::misa_ome_plane_cache::can_pull() const {
 }
 
 void misaxx::ome::misa_ome_plane_cache::pull() {
-    m_cached_image = m_tiff->read_plane(get_plane_location());
+    cv::Mat image = m_tiff->read_plane(get_plane_location());
+    {
+        std::lock_guard<std::mutex> lock(m_cached_image_mutex);
+        m_cached_image = std::move(image);
+        m_evicted = false;
+        m_pinned = false;
+    }
+    track();
 }
 
 void misaxx::ome::misa_ome_plane_cache::stash() {
+    ome_plane_lru::global().remove(this);
+    std::lock_guard<std::mutex> lock(m_cached_image_mutex);
     m_cached_image.release();
+    m_evicted = false;
+    m_pinned = false;
 }
 
 void misaxx::ome::misa_ome_plane_cache::push() {
+    restore();
     if (m_cached_image.empty())
         throw std::runtime_error("Trying to write empty image to TIFF!");
     m_tiff->write_plane(m_cached_image, get_plane_location());
+    {
+        std::lock_guard<std::mutex> lock(m_cached_image_mutex);
+        m_pinned = false;
+    }
+
+    // Planes that were streamed into the OME TIFF cannot be read again until it is closed, but count towards the limit
+    track(!m_tiff->direct_writing_is_enabled());
+}
+
+void misaxx::ome::misa_ome_plane_cache::restore() const {
+    bool empty;
+    {
+        std::lock_guard<std::mutex> lock(m_cached_image_mutex);
+        if(m_evicted) {
+            m_cached_image = m_tiff->read_plane(get_plane_location());
+            m_evicted = false;
+        }
+        empty = m_cached_image.empty();
+    }
+    if(!empty) {
+        track();
+    }
+}
+
+void misaxx::ome::misa_ome_plane_cache::track(bool t_evictable) const {
+    size_t bytes;
+    {
+        std::lock_guard<std::mutex> lock(m_cached_image_mutex);
+        bytes = m_cached_image.total() * m_cached_image.elemSize();
+    }
+    ome_plane_lru::global().touch(this, bytes, [this, t_evictable]() {
+        return t_evictable && try_evict();
+    });
+}
+
+bool misaxx::ome::misa_ome_plane_cache::try_evict() const {
+    std::unique_lock<std::mutex> lock(m_cached_image_mutex, std::try_to_lock);
+    if(!lock.owns_lock())
+        return false;
+    // A reference handed out by get() might still be in use
+    if(m_pinned)
+        return false;
+    // The image is still referenced by another cv::Mat
+    if(m_cached_image.empty() || m_cached_image.u == nullptr || m_cached_image.u->refcount > 1)
+        return false;
+    m_cached_image.release();
+    m_evicted = true;
+    return true;
 }
 
 void misaxx::ome::misa_ome_plane_cache::do_link(const misaxx::ome::misa_ome_plane_description &t_description) {
@@ -54,7 +136,6 @@ void misaxx::ome::misa_ome_plane_cache::do_link(const misaxx::ome::misa_ome_plan
         throw std::runtime_error("Cannot link OME TIFF plane without a TIFF IO!");
     }
     this->set_unique_location(this->get_location() / "planes" /  (misaxx::utils::to_string(t_description) + ".tif"));
-    std::cout << "[Cache] Linking OME TIFF plane @ " << t_description << "\n";
 }
 
 void misaxx::ome::misa_ome_plane_cache::set_tiff_io(std::shared_ptr<misaxx::ome::ome_tiff_io> t_tiff) {
@@ -13,10 +13,15 @@
 #include <misaxx/ome/caches/misa_ome_tiff_cache.h>
 #include <misaxx/ome/attachments/misa_ome_planes_location.h>
 #include <misaxx/core/runtime/misa_parameter_registry.h>
+#include <misaxx/core/runtime/misa_runtime_properties.h>
 #include <src/misaxx/ome/utils/ome_tiff_io.h>
+#include <src/misaxx/ome/utils/ome_plane_lru.h>
 #include <misaxx/core/misa_parameter.h>
 #include <ome/common/log.h>
 #include <misaxx/core/utils/filesystem.h>
+#include <misaxx/core/utils/string.h>
+#include <algorithm>
+#include <fstream>
 
 misaxx::ome::misa_ome_tiff_cache::misa_ome_tiff_cache() {
     m_remove_write_buffer_parameter = misaxx::misa_parameter<bool> { {"runtime", "misaxx-ome", "remove-write-buffer"} };
@@ -31,8 +36,97 @@ misaxx::ome::misa_ome_tiff_cache::misa_ome_tiff_cache() {
 
     m_enable_compression_parameter = misaxx::misa_parameter<bool> { {"runtime", "misaxx-ome", "enable-compression"} };
     m_enable_compression_parameter.schema->document_title("Enable compression of output images")
-            .document_description("If true, output data is compressed with LZW")
+            .document_description("If true, output data is compressed with the codec set in compression-codec")
             .declare_optional(true);
+
+    m_compression_codec_parameter = misaxx::misa_parameter<std::string> { {"runtime", "misaxx-ome", "compression-codec"} };
+    m_compression_codec_parameter.schema->document_title("Compression codec of output images")
+            .document_description("Codec that is used if compression is enabled. Can be none, lzw, deflate or zstd (if supported by libtiff).")
+            .declare_optional(std::string("lzw"));
+
+    m_compression_level_parameter = misaxx::misa_parameter<int> { {"runtime", "misaxx-ome", "compression-level"} };
+    m_compression_level_parameter.schema->document_title("Compression level of output images")
+            .document_description("Compression level of the deflate (1-9) or zstd (1-22) codec. If zero, the default level of the codec is used.")
+            .declare_optional(0);
+
+    m_enable_compression_predictor_parameter = misaxx::misa_parameter<bool> { {"runtime", "misaxx-ome", "enable-compression-predictor"} };
+    m_enable_compression_predictor_parameter.schema->document_title("Enable compression predictor")
+            .document_description("If true, horizontal differencing (floating point differencing for floating point images) is applied before output planes are compressed. "
+                                  "This usually improves the compression of microscopy images.")
+            .declare_optional(false);
+
+    m_enable_direct_writing_parameter = misaxx::misa_parameter<bool> { {"runtime", "misaxx-ome", "enable-direct-writing"} };
+    m_enable_direct_writing_parameter.schema->document_title("Write new OME TIFFs directly")
+            .document_description("If true, planes of new OME TIFFs that are written in storage order are streamed directly into the output file instead of the write buffer. "
+                                  "Such planes cannot be read back until the OME TIFF is written.")
+            .declare_optional(false);
+
+    m_tile_size_parameter = misaxx::misa_parameter<int> { {"runtime", "misaxx-ome", "tile-size"} };
+    m_tile_size_parameter.schema->document_title("Tile size of output images")
+            .document_description("If larger than zero, output OME TIFFs are stored in square tiles of the given size instead of strips. Must be a multiple of 16.")
+            .declare_optional(0);
+
+    m_num_io_threads_parameter = misaxx::misa_parameter<int> { {"runtime", "misaxx-ome", "num-io-threads"} };
+    m_num_io_threads_parameter.schema->document_title("Number of OME TIFF IO threads")
+            .document_description("Number of threads that decode and encode planes of each OME TIFF in parallel. If zero, up to 4 threads are used.")
+            .declare_optional(0);
+
+    m_plane_cache_limit_parameter = misaxx::misa_parameter<int> { {"runtime", "misaxx-ome", "plane-cache-limit"} };
+    m_plane_cache_limit_parameter.schema->document_title("Plane cache memory limit")
+            .document_description("Maximum amount of memory in megabytes that is used by planes read from OME TIFFs. "
+                                  "Least recently used planes are released and read again on demand. If zero, there is no limit.")
+            .declare_optional(0);
+
+    m_prefetch_depth_parameter = misaxx::misa_parameter<int> { {"runtime", "misaxx-ome", "prefetch-depth"} };
+    m_prefetch_depth_parameter.schema->document_title("Number of prefetched planes")
+            .document_description("Number of planes that are decoded in the background after a plane was read. "
+                                  "Prefetched planes must fit into the prefetch memory limit and the plane cache memory limit. If zero, no planes are prefetched.")
+            .declare_optional(0);
+
+    m_prefetch_limit_parameter = misaxx::misa_parameter<int> { {"runtime", "misaxx-ome", "prefetch-limit"} };
+    m_prefetch_limit_parameter.schema->document_title("Prefetch memory limit")
+            .document_description("Maximum amount of memory in megabytes that is used by the prefetched planes of each OME TIFF. "
+                                  "If zero, no planes are prefetched.")
+            .declare_optional(64);
+
+    m_enable_memory_mapping_parameter = misaxx::misa_parameter<bool> { {"runtime", "misaxx-ome", "enable-memory-mapping"} };
+    m_enable_memory_mapping_parameter.schema->document_title("Read uncompressed planes via memory mapping")
+            .document_description("If true, planes of existing OME TIFFs that are stored uncompressed are copied from a memory mapping of the file "
+                                  "instead of being decoded by the OME TIFF reader.")
+            .declare_optional(false);
+
+    m_write_buffer_format_parameter = misaxx::misa_parameter<std::string> { {"runtime", "misaxx-ome", "write-buffer-format"} };
+    m_write_buffer_format_parameter.schema->document_title("Write buffer format")
+            .document_description("How written planes are stored until the OME TIFF is assembled. "
+                                  "files stores each plane as TIFF. log appends the uncompressed planes to one file, "
+                                  "which avoids creating many small files and is read sequentially during assembly.")
+            .declare_optional(std::string("files"));
+
+    m_restore_write_buffer_parameter = misaxx::misa_parameter<bool> { {"runtime", "misaxx-ome", "restore-write-buffer"} };
+    m_restore_write_buffer_parameter.schema->document_title("Restore OME TIFF write buffer")
+            .document_description("If true, planes that an interrupted run wrote into the write buffer of a missing OME TIFF are restored. "
+                                  "Planes are only restored if the OME TIFF has the same metadata and write buffer format.")
+            .declare_optional(false);
+
+    m_pyramid_levels_parameter = misaxx::misa_parameter<int> { {"runtime", "misaxx-ome", "pyramid-levels"} };
+    m_pyramid_levels_parameter.schema->document_title("Number of reduced resolution levels")
+            .document_description("If larger than zero, each plane of output OME TIFFs gets the given number of reduced resolution levels "
+                                  "stored as SubIFDs. Each level halves the width and height of the previous level.")
+            .declare_optional(0);
+
+    m_enable_io_statistics_parameter = misaxx::misa_parameter<bool> { {"runtime", "misaxx-ome", "enable-io-statistics"} };
+    m_enable_io_statistics_parameter.schema->document_title("Write IO statistics")
+            .document_description("If true, the number of read and written bytes and the time spent waiting for locks, decoding, "
+                                  "converting and accessing the write buffer are written as JSON during postprocessing. "
+                                  "The files are located in the misaxx-ome-io-statistics directory of the output folder.")
+            .declare_optional(false);
+
+    m_buffer_pool_limit_parameter = misaxx::misa_parameter<int> { {"runtime", "misaxx-ome", "buffer-pool-limit"} };
+    m_buffer_pool_limit_parameter.schema->document_title("Pixel buffer pool memory limit")
+            .document_description("Maximum amount of memory in megabytes that is kept for recycling the pixel buffers "
+                                  "used while planes are decoded and encoded. The limit is shared between all OME TIFFs. "
+                                  "If zero, the buffers are allocated for each plane.")
+            .declare_optional(64);
 }
 
 void misaxx::ome::misa_ome_tiff_cache::do_link(const misaxx::ome::misa_ome_tiff_description &t_description) {
@@ -60,32 +154,49 @@ void misaxx::ome::misa_ome_tiff_cache::do_link(const misaxx::ome::misa_ome_tiff_
         std::cout << "[Cache] Creating OME TIFF " << this->get_unique_location() << "\n";
 
         // Create the TIFF and generate the image caches
-        m_tiff = std::make_shared<ome_tiff_io>(this->get_unique_location(), t_description.metadata);
+        m_tiff = std::make_shared<ome_tiff_io>(this->get_unique_location(), t_description.metadata,
+                                               ome_write_buffer::parse_format(m_write_buffer_format_parameter.query()));
     }
 
     // Enable compression if needed
-    m_tiff->set_compression(m_enable_compression_parameter.query());
+    ome_tiff_compression compression;
+    if (m_enable_compression_parameter.query()) {
+        compression = ome_tiff_compression(ome_tiff_compression::parse_codec(m_compression_codec_parameter.query()),
+                                           std::max(0, m_compression_level_parameter.query()),
+                                           m_enable_compression_predictor_parameter.query());
+    }
+    m_tiff->set_compression(compression);
+    m_tiff->set_direct_writing(m_enable_direct_writing_parameter.query());
+    m_tiff->set_tile_size(static_cast<::ome::files::dimension_size_type>(std::max(0, m_tile_size_parameter.query())));
+    m_tiff->set_num_threads(static_cast<size_t>(std::max(0, m_num_io_threads_parameter.query())));
+    m_tiff->set_prefetch_depth(static_cast<size_t>(std::max(0, m_prefetch_depth_parameter.query())));
+    m_tiff->set_prefetch_limit(static_cast<size_t>(std::max(0, m_prefetch_limit_parameter.query())) * 1024 * 1024);
+    m_tiff->set_memory_mapping(m_enable_memory_mapping_parameter.query());
+    m_tiff->set_write_buffer_format(ome_write_buffer::parse_format(m_write_buffer_format_parameter.query()));
+    if(m_restore_write_buffer_parameter.query()) {
+        m_tiff->restore_write_buffer();
+    }
+    m_tiff->set_pyramid_levels(static_cast<size_t>(std::max(0, m_pyramid_levels_parameter.query())));
+
+    // The plane cache and pixel buffer pool limits are shared between all OME TIFF caches
+    m_tiff->set_buffer_pool_capacity(static_cast<size_t>(std::max(0, m_buffer_pool_limit_parameter.query())) * 1024 * 1024);
+    ome_plane_lru::global().set_budget(static_cast<size_t>(std::max(0, m_plane_cache_limit_parameter.query())) * 1024 * 1024);
 
-    // Create the plane caches
+    // Plane caches are created on their first access
+    m_series_plane_index.clear();
+    size_t num_planes = 0;
     for (size_t series = 0; series < m_tiff->get_num_series(); ++series) {
-        const auto size_Z = m_tiff->get_size_z(series);
-        const auto size_C = m_tiff->get_size_c(series);
-        const auto size_T = m_tiff->get_size_t(series);
-
-        for (size_t z = 0; z < size_Z; ++z) {
-            for (size_t c = 0; c < size_C; ++c) {
-                for (size_t t = 0; t < size_T; ++t) {
-                    misa_ome_plane cache;
-                    cache.data = std::make_shared<misa_ome_plane_cache>();
-                    cache.data->set_tiff_io(m_tiff);
-                    cache.force_link(this->get_internal_location(),
-                            this->get_location(), misaxx::misa_description_storage::with(
-                            misa_ome_plane_description(series, z, c, t)));
-                    this->get().emplace_back(std::move(cache));
-                }
-            }
-        }
+        series_plane_index series_index;
+        series_index.offset = num_planes;
+        series_index.num_z = m_tiff->get_size_z(series);
+        series_index.num_c = m_tiff->get_size_c(series);
+        series_index.num_t = m_tiff->get_size_t(series);
+        m_series_plane_index.push_back(series_index);
+        num_planes += series_index.num_z * series_index.num_c * series_index.num_t;
     }
+    this->get().clear();
+    this->get().resize(num_planes);
+    m_all_planes_linked = num_planes == 0;
 }
 
 bool misaxx::ome::misa_ome_tiff_cache::has() const {
@@ -98,19 +209,62 @@ std::shared_ptr<misaxx::ome::ome_tiff_io> misaxx::ome::misa_ome_tiff_cache::get_
 
 misaxx::ome::misa_ome_plane
 misaxx::ome::misa_ome_tiff_cache::get_plane(const misaxx::ome::misa_ome_plane_description &t_location) const {
-//            const auto num_series = m_tiff->get_num_series();
-//            const auto size_Z = m_tiff->get_size_z(t_location.series);
-    const auto size_C = m_tiff->get_size_c(t_location.series);
-    const auto size_T = m_tiff->get_size_t(t_location.series);
-
-    // Calculate the plane index
-    size_t start_index = 0;
-    for (size_t series = 0; series < t_location.series; ++series) {
-        start_index += m_tiff->get_num_planes(series);
+    if (t_location.series >= m_series_plane_index.size())
+        throw std::runtime_error("The OME TIFF does not contain the series of plane " + misaxx::utils::to_string(t_location) + "!");
+    const auto &series_index = m_series_plane_index[t_location.series];
+    if (t_location.z >= series_index.num_z || t_location.c >= series_index.num_c || t_location.t >= series_index.num_t)
+        throw std::runtime_error("The OME TIFF does not contain the plane " + misaxx::utils::to_string(t_location) + "!");
+
+    // The plane caches are ordered by series, Z, C and T
+    const size_t index = series_index.offset + t_location.t + series_index.num_t * (t_location.c + series_index.num_c * t_location.z);
+    return get_plane(index);
+}
+
+misaxx::ome::misa_ome_plane misaxx::ome::misa_ome_tiff_cache::get_plane(size_t t_index) const {
+    if (t_index >= this->get().size())
+        throw std::out_of_range("The OME TIFF does not contain a plane with index " + std::to_string(t_index) + "!");
+    if (m_all_planes_linked)
+        return this->get()[t_index];
+    std::lock_guard<std::mutex> lock(m_plane_mutex);
+    link_plane(t_index);
+    return this->get()[t_index];
+}
+
+void misaxx::ome::misa_ome_tiff_cache::link_all_planes() const {
+    if (m_all_planes_linked)
+        return;
+    std::lock_guard<std::mutex> lock(m_plane_mutex);
+    for (size_t index = 0; index < this->get().size(); ++index) {
+        link_plane(index);
     }
+    m_all_planes_linked = true;
+}
 
-    size_t index = start_index + t_location.t + t_location.c * size_T + t_location.z * size_T * size_C;
-    return this->get().at(index);
+void misaxx::ome::misa_ome_tiff_cache::link_plane(size_t t_index) const {
+    // Creating a plane cache on its first access does not change the planes that are visible to users
+    misa_ome_plane &cache = const_cast<std::vector<misa_ome_plane>&>(this->get())[t_index];
+    if (static_cast<bool>(cache.data))
+        return;
+    auto data = std::make_shared<misa_ome_plane_cache>();
+    data->set_tiff_io(m_tiff);
+    misa_ome_plane linked;
+    linked.data = std::move(data);
+    linked.force_link(this->get_internal_location(),
+                      this->get_location(), misaxx::misa_description_storage::with(get_plane_location(t_index)));
+    cache = std::move(linked);
+}
+
+misaxx::ome::misa_ome_plane_description misaxx::ome::misa_ome_tiff_cache::get_plane_location(size_t t_index) const {
+    size_t series = 0;
+    while (series + 1 < m_series_plane_index.size() && m_series_plane_index[series + 1].offset <= t_index) {
+        ++series;
+    }
+    const auto &series_index = m_series_plane_index[series];
+    const size_t index = t_index - series_index.offset;
+    return misa_ome_plane_description(series,
+                                      index / (series_index.num_t * series_index.num_c),
+                                      (index / series_index.num_t) % series_index.num_c,
+                                      index % series_index.num_t);
 }
 
 void misaxx::ome::misa_ome_tiff_cache::postprocess() {
@@ -118,11 +272,26 @@ void misaxx::ome::misa_ome_tiff_cache::postprocess() {
             misa_ome_tiff_pattern, misa_ome_tiff_description>::postprocess();
     if (m_disable_ome_tiff_writing_parameter.query()) {
         std::cout << "[WARNING] No OME TIFF is written, because it is disabled by a parameter!" << "\n";
-        return;
+    }
+    else {
+        // Close the TIFF
+        m_tiff->close(m_remove_write_buffer_parameter.query());
     }
 
-    // Close the TIFF
-    m_tiff->close(m_remove_write_buffer_parameter.query());
+    if (m_enable_io_statistics_parameter.query()) {
+        // Statistics are written into the output directory, even if the OME TIFF is an input
+        const boost::filesystem::path output_path = misaxx::runtime_properties::get_output_path();
+        boost::filesystem::path relative_path = boost::filesystem::relative(this->get_unique_location(), output_path);
+        if (relative_path.empty() || *relative_path.begin() == "..") {
+            relative_path = boost::filesystem::path("inputs") / this->get_unique_location().relative_path();
+        }
+        const boost::filesystem::path statistics_path = output_path / "misaxx-ome-io-statistics" / (relative_path.string() + ".json");
+        boost::filesystem::create_directories(statistics_path.parent_path());
+        nlohmann::json json;
+        m_tiff->get_statistics().to_json(json);
+        std::ofstream stream(statistics_path.string());
+        stream << json.dump(4);
+    }
 }
 
 misaxx::ome::misa_ome_tiff_description
@@ -139,8 +308,9 @@ std::shared_ptr<misaxx::misa_location> misaxx::ome::misa_ome_tiff_cache::create_
     result->filesystem_location = get_location();
     result->filesystem_unique_location = get_unique_location();
 
-    for (const auto &plane : this->get()) {
-        result->planes.push_back(plane.get_plane_location());
+    // Does not create the plane caches that were not accessed yet
+    for (size_t index = 0; index < this->get().size(); ++index) {
+        result->planes.push_back(get_plane_location(index));
     }
 
     return result;
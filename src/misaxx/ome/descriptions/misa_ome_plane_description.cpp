@@ -11,6 +11,7 @@
  */
 
 #include <misaxx/ome/descriptions/misa_ome_plane_description.h>
+#include <tuple>
 
 using namespace misaxx;
 using namespace misaxx::ome;
@@ -88,7 +89,7 @@ bool misa_ome_plane_description::operator==(const misa_ome_plane_description &rh
 }
 
 bool misa_ome_plane_description::operator<(const misa_ome_plane_description &rhs) const {
-    return series < rhs.series || z < rhs.z || c < rhs.c || t < rhs.t;
+    return std::tie(series, z, c, t) < std::tie(rhs.series, rhs.z, rhs.c, rhs.t);
 }
 
 std::string misa_ome_plane_description::get_documentation_name() const {
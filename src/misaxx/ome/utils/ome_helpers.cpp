@@ -72,3 +72,57 @@ misaxx::ome::helpers::create_ome_core_metadata(const ::ome::xml::meta::OMEXMLMet
 
     return core;
 }
+
+::ome::files::dimension_size_type
+misaxx::ome::helpers::get_plane_index(const ::ome::xml::meta::OMEXMLMetadata &t_metadata, size_t series, size_t z,
+                                      size_t c, size_t t) {
+    using namespace ::ome::xml::model::enums;
+
+    const size_t size_Z = t_metadata.getPixelsSizeZ(series);
+    const size_t size_C = t_metadata.getChannelCount(series);
+    const size_t size_T = t_metadata.getPixelsSizeT(series);
+
+    switch(t_metadata.getPixelsDimensionOrder(series)) {
+        case DimensionOrder::XYZCT:
+            return z + size_Z * (c + size_C * t);
+        case DimensionOrder::XYZTC:
+            return z + size_Z * (t + size_T * c);
+        case DimensionOrder::XYCZT:
+            return c + size_C * (z + size_Z * t);
+        case DimensionOrder::XYCTZ:
+            return c + size_C * (t + size_T * z);
+        case DimensionOrder::XYTZC:
+            return t + size_T * (z + size_Z * c);
+        case DimensionOrder::XYTCZ:
+            return t + size_T * (c + size_C * z);
+        default:
+            throw std::runtime_error("Unsupported dimension order!");
+    }
+}
+
+std::array<::ome::files::dimension_size_type, 3>
+misaxx::ome::helpers::get_plane_zct(const ::ome::xml::meta::OMEXMLMetadata &t_metadata, size_t series,
+                                    ::ome::files::dimension_size_type index) {
+    using namespace ::ome::xml::model::enums;
+
+    const size_t size_Z = t_metadata.getPixelsSizeZ(series);
+    const size_t size_C = t_metadata.getChannelCount(series);
+    const size_t size_T = t_metadata.getPixelsSizeT(series);
+
+    switch(t_metadata.getPixelsDimensionOrder(series)) {
+        case DimensionOrder::XYZCT:
+            return { index % size_Z, (index / size_Z) % size_C, index / (size_Z * size_C) };
+        case DimensionOrder::XYZTC:
+            return { index % size_Z, index / (size_Z * size_T), (index / size_Z) % size_T };
+        case DimensionOrder::XYCZT:
+            return { (index / size_C) % size_Z, index % size_C, index / (size_C * size_Z) };
+        case DimensionOrder::XYCTZ:
+            return { index / (size_C * size_T), index % size_C, (index / size_C) % size_T };
+        case DimensionOrder::XYTZC:
+            return { (index / size_T) % size_Z, index / (size_T * size_Z), index % size_T };
+        case DimensionOrder::XYTCZ:
+            return { index / (size_T * size_C), (index / size_T) % size_C, index % size_T };
+        default:
+            throw std::runtime_error("Unsupported dimension order!");
+    }
+}
@@ -0,0 +1,194 @@
+/**
+ * Copyright by Ruman Gerst
+ * Research Group Applied Systems Biology - Head: Prof. Dr. Marc Thilo Figge
+ * https://www.leibniz-hki.de/en/applied-systems-biology.html
+ * HKI-Center for Systems Biology of Infection
+ * Leibniz Institute for Natural Product Research and Infection Biology - Hans Knöll Insitute (HKI)
+ * Adolf-Reichwein-Straße 23, 07745 Jena, Germany
+ *
+ * This code is licensed under BSD 2-Clause
+ * See the LICENSE file provided with this code for the full license.
+ */
+
+#include "ome_pixel_buffer_pool.h"
+#include <ome/files/PixelProperties.h>
+#include <algorithm>
+#include <iterator>
+
+using namespace misaxx::ome;
+
+namespace {
+
+    size_t get_ome_buffer_bytes(::ome::files::dimension_size_type size_x, ::ome::files::dimension_size_type size_y,
+                                ::ome::files::dimension_size_type channels, ::ome::xml::model::enums::PixelType pixel_type) {
+        return static_cast<size_t>(size_x * size_y * channels * ::ome::files::bytesPerPixel(pixel_type));
+    }
+
+    size_t get_mat_bytes(int rows, int cols, int opencv_type) {
+        return static_cast<size_t>(rows) * static_cast<size_t>(cols) * CV_ELEM_SIZE(opencv_type);
+    }
+
+    bool is_unused(const std::shared_ptr<::ome::files::VariantPixelBuffer> &t_buffer) {
+        return t_buffer.use_count() == 1;
+    }
+
+    bool is_unused(const cv::Mat &t_mat) {
+        return t_mat.u != nullptr && t_mat.u->refcount == 1;
+    }
+}
+
+std::shared_ptr<::ome::files::VariantPixelBuffer>
+ome_pixel_buffer_pool::get_ome_buffer(::ome::files::dimension_size_type size_x, ::ome::files::dimension_size_type size_y,
+                                      ::ome::files::dimension_size_type channels, ::ome::xml::model::enums::PixelType pixel_type) {
+    using namespace ::ome::files;
+    const ome_buffer_key key(size_x, size_y, channels, static_cast<int>(pixel_type));
+    std::lock_guard<std::mutex> lock(m_mutex);
+    ++m_clock;
+    auto &buffers = m_ome_buffers[key];
+    for(auto &entry : buffers) {
+        if(is_unused(entry.buffer)) {
+            entry.last_used = m_clock;
+            return entry.buffer;
+        }
+    }
+
+    auto result = std::make_shared<VariantPixelBuffer>();
+    result->setBuffer(boost::extents[size_x][size_y][1][1][1][channels][1][1][1], pixel_type, ENDIAN_NATIVE,
+            PixelBufferBase::make_storage_order(::ome::xml::model::enums::DimensionOrder::XYZTC, true));
+    if(reserve(get_ome_buffer_bytes(size_x, size_y, channels, pixel_type))) {
+        // reserve() might have removed unused entries, so the key is looked up again
+        m_ome_buffers[key].push_back({ result, m_clock });
+    }
+    return result;
+}
+
+cv::Mat ome_pixel_buffer_pool::get_mat(int rows, int cols, int opencv_type) {
+    const mat_key key(rows, cols, opencv_type);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    ++m_clock;
+    auto &mats = m_mats[key];
+    for(auto &entry : mats) {
+        if(is_unused(entry.buffer)) {
+            entry.last_used = m_clock;
+            return entry.buffer;
+        }
+    }
+
+    cv::Mat result(rows, cols, opencv_type);
+    if(reserve(get_mat_bytes(rows, cols, opencv_type))) {
+        m_mats[key].push_back({ result, m_clock });
+    }
+    return result;
+}
+
+size_t ome_pixel_buffer_pool::get_capacity() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_capacity;
+}
+
+void ome_pixel_buffer_pool::set_capacity(size_t t_capacity) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_capacity = t_capacity;
+    while(m_size > m_capacity && release_least_recently_used()) {
+    }
+}
+
+size_t ome_pixel_buffer_pool::get_size() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_size;
+}
+
+void ome_pixel_buffer_pool::clear() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    release_unused();
+}
+
+ome_pixel_buffer_pool &ome_pixel_buffer_pool::global() {
+    static ome_pixel_buffer_pool instance;
+    return instance;
+}
+
+bool ome_pixel_buffer_pool::reserve(size_t t_bytes) {
+    if(t_bytes > m_capacity)
+        return false;
+    while(m_size + t_bytes > m_capacity) {
+        if(!release_least_recently_used())
+            return false;
+    }
+    m_size += t_bytes;
+    return true;
+}
+
+bool ome_pixel_buffer_pool::release_least_recently_used() {
+    // Find the oldest unused buffer of both kinds
+    auto oldest_ome_buffer = m_ome_buffers.end();
+    size_t oldest_ome_buffer_index = 0;
+    for(auto it = m_ome_buffers.begin(); it != m_ome_buffers.end(); ++it) {
+        for(size_t i = 0; i < it->second.size(); ++i) {
+            const auto &entry = it->second[i];
+            if(is_unused(entry.buffer) && (oldest_ome_buffer == m_ome_buffers.end() ||
+                entry.last_used < oldest_ome_buffer->second[oldest_ome_buffer_index].last_used)) {
+                oldest_ome_buffer = it;
+                oldest_ome_buffer_index = i;
+            }
+        }
+    }
+    auto oldest_mat = m_mats.end();
+    size_t oldest_mat_index = 0;
+    for(auto it = m_mats.begin(); it != m_mats.end(); ++it) {
+        for(size_t i = 0; i < it->second.size(); ++i) {
+            const auto &entry = it->second[i];
+            if(is_unused(entry.buffer) && (oldest_mat == m_mats.end() ||
+                entry.last_used < oldest_mat->second[oldest_mat_index].last_used)) {
+                oldest_mat = it;
+                oldest_mat_index = i;
+            }
+        }
+    }
+
+    const bool has_ome_buffer = oldest_ome_buffer != m_ome_buffers.end();
+    const bool has_mat = oldest_mat != m_mats.end();
+    if(!has_ome_buffer && !has_mat)
+        return false;
+
+    if(has_ome_buffer && (!has_mat || oldest_ome_buffer->second[oldest_ome_buffer_index].last_used < oldest_mat->second[oldest_mat_index].last_used)) {
+        const auto &key = oldest_ome_buffer->first;
+        m_size -= get_ome_buffer_bytes(std::get<0>(key), std::get<1>(key), std::get<2>(key),
+                static_cast<::ome::xml::model::enums::PixelType::enum_value>(std::get<3>(key)));
+        auto &buffers = oldest_ome_buffer->second;
+        buffers.erase(buffers.begin() + static_cast<std::ptrdiff_t>(oldest_ome_buffer_index));
+        if(buffers.empty()) {
+            m_ome_buffers.erase(oldest_ome_buffer);
+        }
+    }
+    else {
+        const auto &key = oldest_mat->first;
+        m_size -= get_mat_bytes(std::get<0>(key), std::get<1>(key), std::get<2>(key));
+        auto &mats = oldest_mat->second;
+        mats.erase(mats.begin() + static_cast<std::ptrdiff_t>(oldest_mat_index));
+        if(mats.empty()) {
+            m_mats.erase(oldest_mat);
+        }
+    }
+    return true;
+}
+
+void ome_pixel_buffer_pool::release_unused() {
+    for(auto it = m_ome_buffers.begin(); it != m_ome_buffers.end();) {
+        auto &buffers = it->second;
+        const size_t bytes = get_ome_buffer_bytes(std::get<0>(it->first), std::get<1>(it->first), std::get<2>(it->first),
+                static_cast<::ome::xml::model::enums::PixelType::enum_value>(std::get<3>(it->first)));
+        const auto unused = std::remove_if(buffers.begin(), buffers.end(), [](const auto &entry) { return is_unused(entry.buffer); });
+        m_size -= bytes * static_cast<size_t>(std::distance(unused, buffers.end()));
+        buffers.erase(unused, buffers.end());
+        it = buffers.empty() ? m_ome_buffers.erase(it) : std::next(it);
+    }
+    for(auto it = m_mats.begin(); it != m_mats.end();) {
+        auto &mats = it->second;
+        const size_t bytes = get_mat_bytes(std::get<0>(it->first), std::get<1>(it->first), std::get<2>(it->first));
+        const auto unused = std::remove_if(mats.begin(), mats.end(), [](const auto &entry) { return is_unused(entry.buffer); });
+        m_size -= bytes * static_cast<size_t>(std::distance(unused, mats.end()));
+        mats.erase(unused, mats.end());
+        it = mats.empty() ? m_mats.erase(it) : std::next(it);
+    }
+}
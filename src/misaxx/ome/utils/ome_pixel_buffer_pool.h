@@ -0,0 +1,133 @@
+/**
+ * Copyright by Ruman Gerst
+ * Research Group Applied Systems Biology - Head: Prof. Dr. Marc Thilo Figge
+ * https://www.leibniz-hki.de/en/applied-systems-biology.html
+ * HKI-Center for Systems Biology of Infection
+ * Leibniz Institute for Natural Product Research and Infection Biology - Hans Knöll Insitute (HKI)
+ * Adolf-Reichwein-Straße 23, 07745 Jena, Germany
+ *
+ * This code is licensed under BSD 2-Clause
+ * See the LICENSE file provided with this code for the full license.
+ */
+
+#pragma once
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <vector>
+#include <opencv2/opencv.hpp>
+#include <ome/files/Types.h>
+#include <ome/files/VariantPixelBuffer.h>
+
+namespace misaxx::ome {
+
+    /**
+     * Recycles plane-sized pixel buffers that are only needed while a plane is decoded or encoded.
+     * Buffers are grouped by their shape and pixel type. A buffer is handed out again once it is
+     * not referenced outside of the pool anymore.
+     * As the pool keeps a reference to each buffer, buffers must not be passed to callers that keep them.
+     * If the capacity is exceeded, the least recently used buffers that are not in use are released.
+     * All methods are thread-safe.
+     */
+    class ome_pixel_buffer_pool {
+    public:
+
+        ome_pixel_buffer_pool() = default;
+
+        ome_pixel_buffer_pool(const ome_pixel_buffer_pool &) = delete;
+
+        ome_pixel_buffer_pool &operator=(const ome_pixel_buffer_pool &) = delete;
+
+        /**
+         * Returns an OME pixel buffer that can hold a plane with interleaved subchannels.
+         * Readers keep the buffer if its shape and pixel type match the decoded plane.
+         * @param size_x
+         * @param size_y
+         * @param channels Number of subchannels
+         * @param pixel_type
+         * @return
+         */
+        std::shared_ptr<::ome::files::VariantPixelBuffer> get_ome_buffer(::ome::files::dimension_size_type size_x,
+                ::ome::files::dimension_size_type size_y,
+                ::ome::files::dimension_size_type channels,
+                ::ome::xml::model::enums::PixelType pixel_type);
+
+        /**
+         * Returns a continuous cv::Mat
+         * @param rows
+         * @param cols
+         * @param opencv_type
+         * @return
+         */
+        cv::Mat get_mat(int rows, int cols, int opencv_type);
+
+        /**
+         * Maximum memory in bytes that is kept by the pool. Buffers that do not fit are not recycled.
+         * @return
+         */
+        size_t get_capacity() const;
+
+        /**
+         * Sets the maximum memory in bytes that is kept by the pool. If zero, no buffers are recycled.
+         * @param t_capacity
+         */
+        void set_capacity(size_t t_capacity);
+
+        /**
+         * Memory in bytes that is kept by the pool
+         * @return
+         */
+        size_t get_size() const;
+
+        /**
+         * Releases all buffers that are not in use
+         */
+        void clear();
+
+        /**
+         * Shared instance that recycles the buffers of all OME TIFFs of the current process
+         * @return
+         */
+        static ome_pixel_buffer_pool &global();
+
+    private:
+
+        using ome_buffer_key = std::tuple<::ome::files::dimension_size_type, ::ome::files::dimension_size_type,
+                ::ome::files::dimension_size_type, int>;
+        using mat_key = std::tuple<int, int, int>;
+
+        template<typename Buffer> struct entry {
+            Buffer buffer;
+            size_t last_used;
+        };
+
+        std::map<ome_buffer_key, std::vector<entry<std::shared_ptr<::ome::files::VariantPixelBuffer>>>> m_ome_buffers;
+        std::map<mat_key, std::vector<entry<cv::Mat>>> m_mats;
+        size_t m_size = 0;
+        size_t m_capacity = 64 * 1024 * 1024;
+
+        /**
+         * Incremented each time a buffer is handed out
+         */
+        size_t m_clock = 0;
+        mutable std::mutex m_mutex;
+
+        /**
+         * Releases the least recently used buffers that are not in use until the buffer fits into the capacity.
+         * m_mutex must be locked.
+         * @param t_bytes
+         * @return True if the buffer fits into the capacity
+         */
+        bool reserve(size_t t_bytes);
+
+        /**
+         * Releases the least recently used buffer that is not in use. m_mutex must be locked.
+         * @return False if all buffers are in use
+         */
+        bool release_least_recently_used();
+
+        void release_unused();
+    };
+}
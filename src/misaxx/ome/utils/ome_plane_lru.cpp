@@ -0,0 +1,88 @@
+/**
+ * Copyright by Ruman Gerst
+ * Research Group Applied Systems Biology - Head: Prof. Dr. Marc Thilo Figge
+ * https://www.leibniz-hki.de/en/applied-systems-biology.html
+ * HKI-Center for Systems Biology of Infection
+ * Leibniz Institute for Natural Product Research and Infection Biology - Hans Knöll Insitute (HKI)
+ * Adolf-Reichwein-Straße 23, 07745 Jena, Germany
+ *
+ * This code is licensed under BSD 2-Clause
+ * See the LICENSE file provided with this code for the full license.
+ */
+
+#include "ome_plane_lru.h"
+
+using namespace misaxx::ome;
+
+void ome_plane_lru::touch(const void *t_key, size_t t_bytes, const ome_plane_lru::evict_function &t_evict) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if(m_budget == 0)
+        return;
+
+    const auto it = m_index.find(t_key);
+    if(it != m_index.end()) {
+        m_size -= it->second->bytes;
+        m_entries.erase(it->second);
+    }
+    m_entries.push_front(entry { t_key, t_bytes, t_evict });
+    m_index[t_key] = m_entries.begin();
+    m_size += t_bytes;
+
+    evict_until_within_budget(t_key);
+}
+
+void ome_plane_lru::remove(const void *t_key) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const auto it = m_index.find(t_key);
+    if(it != m_index.end()) {
+        m_size -= it->second->bytes;
+        m_entries.erase(it->second);
+        m_index.erase(it);
+    }
+}
+
+bool ome_plane_lru::has_space(size_t t_bytes) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_budget == 0 || m_size + t_bytes <= m_budget;
+}
+
+size_t ome_plane_lru::get_budget() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_budget;
+}
+
+void ome_plane_lru::set_budget(size_t t_budget) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_budget = t_budget;
+    if(m_budget == 0) {
+        m_entries.clear();
+        m_index.clear();
+        m_size = 0;
+    }
+    else {
+        evict_until_within_budget(nullptr);
+    }
+}
+
+size_t ome_plane_lru::get_size() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_size;
+}
+
+ome_plane_lru &ome_plane_lru::global() {
+    static ome_plane_lru instance;
+    return instance;
+}
+
+void ome_plane_lru::evict_until_within_budget(const void *t_except) {
+    // Planes that are in use are skipped
+    auto it = m_entries.end();
+    while(m_size > m_budget && it != m_entries.begin()) {
+        --it;
+        if(it->key == t_except || !it->evict())
+            continue;
+        m_size -= it->bytes;
+        m_index.erase(it->key);
+        it = m_entries.erase(it);
+    }
+}
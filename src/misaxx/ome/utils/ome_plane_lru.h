@@ -0,0 +1,106 @@
+/**
+ * Copyright by Ruman Gerst
+ * Research Group Applied Systems Biology - Head: Prof. Dr. Marc Thilo Figge
+ * https://www.leibniz-hki.de/en/applied-systems-biology.html
+ * HKI-Center for Systems Biology of Infection
+ * Leibniz Institute for Natural Product Research and Infection Biology - Hans Knöll Insitute (HKI)
+ * Adolf-Reichwein-Straße 23, 07745 Jena, Germany
+ *
+ * This code is licensed under BSD 2-Clause
+ * See the LICENSE file provided with this code for the full license.
+ */
+
+#pragma once
+
+#include <functional>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+namespace misaxx::ome {
+
+    /**
+     * Keeps track of the memory that is used by cached planes and evicts the least recently used planes
+     * if a memory budget is exceeded.
+     * The planes are not stored in this structure. Instead, each plane provides a function that releases its memory.
+     */
+    class ome_plane_lru {
+    public:
+
+        /**
+         * Function that releases the memory of a plane.
+         * Returns false if the plane is currently in use and cannot be evicted.
+         */
+        using evict_function = std::function<bool()>;
+
+        ome_plane_lru() = default;
+
+        ome_plane_lru(const ome_plane_lru &) = delete;
+
+        ome_plane_lru &operator=(const ome_plane_lru &) = delete;
+
+        /**
+         * Marks a plane as most recently used and evicts other planes if the memory budget is exceeded
+         * @param t_key Unique key of the plane
+         * @param t_bytes Memory used by the plane
+         * @param t_evict Function that releases the memory of the plane
+         */
+        void touch(const void *t_key, size_t t_bytes, const evict_function &t_evict);
+
+        /**
+         * Stops tracking a plane. Must be called if the plane memory was released or is not allowed to be evicted.
+         * @param t_key
+         */
+        void remove(const void *t_key);
+
+        /**
+         * Returns true if a plane of the given size can be added without evicting other planes
+         * @param t_bytes
+         * @return
+         */
+        bool has_space(size_t t_bytes) const;
+
+        /**
+         * Memory budget in bytes. Zero if there is no limit.
+         * @return
+         */
+        size_t get_budget() const;
+
+        /**
+         * Sets the memory budget in bytes. If zero, no planes are evicted.
+         * @param t_budget
+         */
+        void set_budget(size_t t_budget);
+
+        /**
+         * Memory used by tracked planes in bytes
+         * @return
+         */
+        size_t get_size() const;
+
+        /**
+         * Shared instance that tracks all planes of the current process
+         * @return
+         */
+        static ome_plane_lru &global();
+
+    private:
+
+        struct entry {
+            const void *key;
+            size_t bytes;
+            evict_function evict;
+        };
+
+        /**
+         * Planes ordered from most recently to least recently used
+         */
+        std::list<entry> m_entries;
+        std::unordered_map<const void*, std::list<entry>::iterator> m_index;
+        size_t m_size = 0;
+        size_t m_budget = 0;
+        mutable std::mutex m_mutex;
+
+        void evict_until_within_budget(const void *t_except);
+    };
+}
@@ -0,0 +1,355 @@
+/**
+ * Copyright by Ruman Gerst
+ * Research Group Applied Systems Biology - Head: Prof. Dr. Marc Thilo Figge
+ * https://www.leibniz-hki.de/en/applied-systems-biology.html
+ * HKI-Center for Systems Biology of Infection
+ * Leibniz Institute for Natural Product Research and Infection Biology - Hans Knöll Insitute (HKI)
+ * Adolf-Reichwein-Straße 23, 07745 Jena, Germany
+ *
+ * This code is licensed under BSD 2-Clause
+ * See the LICENSE file provided with this code for the full license.
+ */
+
+#include "ome_tiff_compression.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <future>
+#include <memory>
+
+using namespace misaxx::ome;
+
+namespace {
+
+    using tiff_handle = std::unique_ptr<TIFF, decltype(&TIFFClose)>;
+
+    /**
+     * TIFF file that is stored in memory. Used to compress strips and tiles with libtiff in parallel.
+     */
+    struct memory_tiff {
+        std::vector<uchar> data;
+        toff_t position = 0;
+
+        /**
+         * Opens the file for writing. The file must outlive the returned TIFF.
+         * @return
+         */
+        TIFF *open() {
+            return TIFFClientOpen("memory", "w8", static_cast<thandle_t>(this), &memory_tiff::read, &memory_tiff::write,
+                    &memory_tiff::seek, &memory_tiff::close, &memory_tiff::size, &memory_tiff::map, &memory_tiff::unmap);
+        }
+
+        static tmsize_t read(thandle_t, void *, tmsize_t) {
+            return 0;
+        }
+
+        static tmsize_t write(thandle_t t_handle, void *t_buffer, tmsize_t t_size) {
+            auto &file = *static_cast<memory_tiff*>(t_handle);
+            const toff_t end = file.position + static_cast<toff_t>(t_size);
+            if(file.data.size() < end) {
+                file.data.resize(end);
+            }
+            std::memcpy(file.data.data() + file.position, t_buffer, static_cast<size_t>(t_size));
+            file.position = end;
+            return t_size;
+        }
+
+        static toff_t seek(thandle_t t_handle, toff_t t_offset, int t_whence) {
+            auto &file = *static_cast<memory_tiff*>(t_handle);
+            switch(t_whence) {
+                case SEEK_CUR:
+                    file.position += t_offset;
+                    break;
+                case SEEK_END:
+                    file.position = file.data.size() + t_offset;
+                    break;
+                default:
+                    file.position = t_offset;
+                    break;
+            }
+            return file.position;
+        }
+
+        static int close(thandle_t) {
+            return 0;
+        }
+
+        static toff_t size(thandle_t t_handle) {
+            return static_cast<memory_tiff*>(t_handle)->data.size();
+        }
+
+        static int map(thandle_t, void **, toff_t *) {
+            return 0;
+        }
+
+        static void unmap(thandle_t, void *, toff_t) {
+        }
+    };
+
+    uint16_t get_tiff_sample_format(int depth) {
+        switch(depth) {
+            case CV_8S:
+            case CV_16S:
+            case CV_32S:
+                return SAMPLEFORMAT_INT;
+            case CV_32F:
+            case CV_64F:
+                return SAMPLEFORMAT_IEEEFP;
+            default:
+                return SAMPLEFORMAT_UINT;
+        }
+    }
+}
+
+int misaxx::ome::ome_tiff_get_opencv_depth(uint16_t t_bits_per_sample, uint16_t t_sample_format) {
+    switch(t_sample_format) {
+        case SAMPLEFORMAT_UINT:
+            return t_bits_per_sample == 8 ? CV_8U : t_bits_per_sample == 16 ? CV_16U : -1;
+        case SAMPLEFORMAT_INT:
+            return t_bits_per_sample == 8 ? CV_8S : t_bits_per_sample == 16 ? CV_16S : t_bits_per_sample == 32 ? CV_32S : -1;
+        case SAMPLEFORMAT_IEEEFP:
+            return t_bits_per_sample == 32 ? CV_32F : t_bits_per_sample == 64 ? CV_64F : -1;
+        default:
+            return -1;
+    }
+}
+
+int misaxx::ome::ome_tiff_get_compression_scheme(ome_tiff_codec codec) {
+    switch(codec) {
+        case ome_tiff_codec::none:
+            return COMPRESSION_NONE;
+        case ome_tiff_codec::lzw:
+            return COMPRESSION_LZW;
+        case ome_tiff_codec::deflate:
+            return COMPRESSION_ADOBE_DEFLATE;
+        case ome_tiff_codec::zstd:
+#ifdef COMPRESSION_ZSTD
+            return COMPRESSION_ZSTD;
+#else
+            return -1;
+#endif
+        default:
+            return -1;
+    }
+}
+
+ome_tiff_compression::ome_tiff_compression(ome_tiff_codec t_codec, int t_level, bool t_predictor) :
+        codec(t_codec), level(t_level), predictor(t_predictor) {
+
+}
+
+bool ome_tiff_compression::is_enabled() const {
+    return codec != ome_tiff_codec::none;
+}
+
+bool ome_tiff_compression::is_supported() const {
+    const int scheme = ome_tiff_get_compression_scheme(codec);
+    return scheme >= 0 && TIFFIsCODECConfigured(static_cast<uint16_t>(scheme)) != 0;
+}
+
+ome_tiff_codec ome_tiff_compression::parse_codec(const std::string &t_name) {
+    if(t_name == "none")
+        return ome_tiff_codec::none;
+    if(t_name == "lzw")
+        return ome_tiff_codec::lzw;
+    if(t_name == "deflate")
+        return ome_tiff_codec::deflate;
+    if(t_name == "zstd")
+        return ome_tiff_codec::zstd;
+    throw std::runtime_error("Unsupported TIFF compression codec " + t_name + "! Supported are none, lzw, deflate and zstd.");
+}
+
+void misaxx::ome::ome_tiff_set_compression_fields(TIFF *t_tif, int t_opencv_depth, const ome_tiff_compression &t_compression) {
+    if(!t_compression.is_enabled()) {
+        TIFFSetField(t_tif, TIFFTAG_COMPRESSION, COMPRESSION_NONE);
+        return;
+    }
+    if(!t_compression.is_supported())
+        throw std::runtime_error("The TIFF compression codec is not supported by libtiff!");
+    TIFFSetField(t_tif, TIFFTAG_COMPRESSION, static_cast<uint16_t>(ome_tiff_get_compression_scheme(t_compression.codec)));
+    if(t_compression.predictor) {
+        const bool floating_point = t_opencv_depth == CV_32F || t_opencv_depth == CV_64F;
+        TIFFSetField(t_tif, TIFFTAG_PREDICTOR, floating_point ? PREDICTOR_FLOATINGPOINT : PREDICTOR_HORIZONTAL);
+    }
+    // The level is not stored in the TIFF and applies to the current directory
+    if(t_compression.level > 0) {
+        if(t_compression.codec == ome_tiff_codec::deflate) {
+            TIFFSetField(t_tif, TIFFTAG_ZIPQUALITY, std::min(t_compression.level, 9));
+        }
+#ifdef TIFFTAG_ZSTD_LEVEL
+        else if(t_compression.codec == ome_tiff_codec::zstd) {
+            TIFFSetField(t_tif, TIFFTAG_ZSTD_LEVEL, std::min(t_compression.level, 22));
+        }
+#endif
+    }
+}
+
+void misaxx::ome::ome_tiff_write_image(TIFF *t_tif, const cv::Mat &t_image, const ome_tiff_compression &t_compression,
+                                       uint32_t t_tile_size, ome_worker_pool *t_workers) {
+    if(t_image.empty())
+        throw std::runtime_error("Trying to write empty image to TIFF!");
+
+    const cv::Mat &image = t_image;
+    const bool tiled = t_tile_size > 0;
+    const auto set_fields = [&image, &t_compression](TIFF *tif) {
+        const auto channels = static_cast<uint16_t>(image.channels());
+        TIFFSetField(tif, TIFFTAG_IMAGEWIDTH, static_cast<uint32_t>(image.cols));
+        TIFFSetField(tif, TIFFTAG_IMAGELENGTH, static_cast<uint32_t>(image.rows));
+        TIFFSetField(tif, TIFFTAG_BITSPERSAMPLE, static_cast<uint16_t>(image.elemSize1() * 8));
+        TIFFSetField(tif, TIFFTAG_SAMPLESPERPIXEL, channels);
+        TIFFSetField(tif, TIFFTAG_SAMPLEFORMAT, get_tiff_sample_format(image.depth()));
+        TIFFSetField(tif, TIFFTAG_PLANARCONFIG, PLANARCONFIG_CONTIG);
+        if(channels == 3) {
+            TIFFSetField(tif, TIFFTAG_PHOTOMETRIC, PHOTOMETRIC_RGB);
+        }
+        else {
+            TIFFSetField(tif, TIFFTAG_PHOTOMETRIC, PHOTOMETRIC_MINISBLACK);
+            if(channels > 1) {
+                std::vector<uint16_t> extra_samples(channels - 1, EXTRASAMPLE_UNSPECIFIED);
+                TIFFSetField(tif, TIFFTAG_EXTRASAMPLES, static_cast<uint16_t>(extra_samples.size()), extra_samples.data());
+            }
+        }
+        ome_tiff_set_compression_fields(tif, image.depth(), t_compression);
+    };
+    set_fields(t_tif);
+
+    // Strips span all columns. Tiles are square and edge tiles are padded.
+    std::vector<cv::Rect> blocks;
+    uint32_t rows_per_strip = 0;
+    if(!tiled) {
+        rows_per_strip = std::max<uint32_t>(1, TIFFDefaultStripSize(t_tif, 0));
+        TIFFSetField(t_tif, TIFFTAG_ROWSPERSTRIP, rows_per_strip);
+        for(int y = 0; y < image.rows; y += static_cast<int>(rows_per_strip)) {
+            blocks.emplace_back(0, y, image.cols, std::min(static_cast<int>(rows_per_strip), image.rows - y));
+        }
+    }
+    else {
+        TIFFSetField(t_tif, TIFFTAG_TILEWIDTH, t_tile_size);
+        TIFFSetField(t_tif, TIFFTAG_TILELENGTH, t_tile_size);
+        const auto tile_size = static_cast<int>(t_tile_size);
+        for(int y = 0; y < image.rows; y += tile_size) {
+            for(int x = 0; x < image.cols; x += tile_size) {
+                blocks.emplace_back(x, y, std::min(tile_size, image.cols - x), std::min(tile_size, image.rows - y));
+            }
+        }
+    }
+    const auto set_layout = [&](TIFF *tif) {
+        set_fields(tif);
+        if(tiled) {
+            TIFFSetField(tif, TIFFTAG_TILEWIDTH, t_tile_size);
+            TIFFSetField(tif, TIFFTAG_TILELENGTH, t_tile_size);
+        }
+        else {
+            TIFFSetField(tif, TIFFTAG_ROWSPERSTRIP, rows_per_strip);
+        }
+    };
+
+    // libtiff applies the predictor in place, so each strip or tile is copied first
+    const auto copy_block = [&image, tiled, t_tile_size](const cv::Rect &block) {
+        cv::Mat result = tiled ? cv::Mat::zeros(static_cast<int>(t_tile_size), static_cast<int>(t_tile_size), image.type()) :
+                cv::Mat(block.height, block.width, image.type());
+        image(block).copyTo(result(cv::Rect(0, 0, block.width, block.height)));
+        return result;
+    };
+    const auto get_block_index = [&](TIFF *tif, const cv::Rect &block) {
+        return tiled ? TIFFComputeTile(tif, static_cast<uint32_t>(block.x), static_cast<uint32_t>(block.y), 0, 0) :
+               TIFFComputeStrip(tif, static_cast<uint32_t>(block.y), 0);
+    };
+
+    const size_t num_threads = t_workers != nullptr ? t_workers->get_num_threads() + 1 : 1;
+    const size_t num_workers = t_compression.is_enabled() ? std::max<size_t>(1, std::min(num_threads, blocks.size())) : 1;
+    if(num_workers == 1) {
+        for(const cv::Rect &block : blocks) {
+            cv::Mat data = copy_block(block);
+            const auto bytes = static_cast<tmsize_t>(data.total() * data.elemSize());
+            const tmsize_t written = tiled ? TIFFWriteEncodedTile(t_tif, get_block_index(t_tif, block), data.data, bytes) :
+                                     TIFFWriteEncodedStrip(t_tif, get_block_index(t_tif, block), data.data, bytes);
+            if(written < 0)
+                throw std::runtime_error(tiled ? "Could not write TIFF tile!" : "Could not write TIFF strip!");
+        }
+        return;
+    }
+
+    // Each worker compresses a contiguous range of blocks into an in-memory TIFF with the same layout.
+    // The compressed blocks are then written in order.
+    std::vector<std::vector<uchar>> encoded(blocks.size());
+    const size_t chunk_size = (blocks.size() + num_workers - 1) / num_workers;
+    const auto encode_range = [&](size_t first, size_t last) {
+        memory_tiff file;
+        tiff_handle tif(file.open(), &TIFFClose);
+        if(!tif)
+            throw std::runtime_error("Could not create in-memory TIFF!");
+        set_layout(tif.get());
+        for(size_t i = first; i < last; ++i) {
+            cv::Mat data = copy_block(blocks[i]);
+            const auto index = get_block_index(tif.get(), blocks[i]);
+            const auto bytes = static_cast<tmsize_t>(data.total() * data.elemSize());
+            const tmsize_t written = tiled ? TIFFWriteEncodedTile(tif.get(), index, data.data, bytes) :
+                                     TIFFWriteEncodedStrip(tif.get(), index, data.data, bytes);
+            if(written < 0)
+                throw std::runtime_error(tiled ? "Could not compress TIFF tile!" : "Could not compress TIFF strip!");
+
+            uint64_t *offsets = nullptr;
+            uint64_t *byte_counts = nullptr;
+            if(!TIFFGetField(tif.get(), tiled ? TIFFTAG_TILEOFFSETS : TIFFTAG_STRIPOFFSETS, &offsets) ||
+               !TIFFGetField(tif.get(), tiled ? TIFFTAG_TILEBYTECOUNTS : TIFFTAG_STRIPBYTECOUNTS, &byte_counts))
+                throw std::runtime_error("Could not locate compressed TIFF data!");
+            const auto begin = file.data.begin() + static_cast<std::ptrdiff_t>(offsets[index]);
+            encoded[i].assign(begin, begin + static_cast<std::ptrdiff_t>(byte_counts[index]));
+        }
+    };
+
+    std::vector<std::future<void>> workers;
+    for(size_t first = chunk_size; first < blocks.size(); first += chunk_size) {
+        const size_t last = std::min(first + chunk_size, blocks.size());
+        workers.emplace_back(t_workers->submit([&encode_range, first, last]() {
+            encode_range(first, last);
+        }));
+    }
+
+    // The first range is compressed by this thread. All workers must finish before an error is reported.
+    std::exception_ptr error;
+    try {
+        encode_range(0, std::min(chunk_size, blocks.size()));
+    }
+    catch(...) {
+        error = std::current_exception();
+    }
+    for(auto &worker : workers) {
+        try {
+            worker.get();
+        }
+        catch(...) {
+            if(!error)
+                error = std::current_exception();
+        }
+    }
+    if(error)
+        std::rethrow_exception(error);
+
+    for(size_t i = 0; i < blocks.size(); ++i) {
+        const auto index = get_block_index(t_tif, blocks[i]);
+        const auto bytes = static_cast<tmsize_t>(encoded[i].size());
+        const tmsize_t written = tiled ? TIFFWriteRawTile(t_tif, index, encoded[i].data(), bytes) :
+                                 TIFFWriteRawStrip(t_tif, index, encoded[i].data(), bytes);
+        if(written < 0)
+            throw std::runtime_error(tiled ? "Could not write TIFF tile!" : "Could not write TIFF strip!");
+    }
+}
+
+void misaxx::ome::ome_tiff_write_compressed(const cv::Mat &t_image, const boost::filesystem::path &t_path,
+                                            const ome_tiff_compression &t_compression) {
+    if(t_image.empty())
+        throw std::runtime_error("Trying to write empty image to TIFF!");
+
+    // Large planes require BigTIFF
+    const size_t image_bytes = t_image.total() * t_image.elemSize();
+    tiff_handle tif(TIFFOpen(t_path.string().c_str(), image_bytes > 0x7FFFFFFF ? "w8" : "w"), &TIFFClose);
+    if(!tif)
+        throw std::runtime_error("Could not open " + t_path.string() + " for writing!");
+
+    ome_tiff_write_image(tif.get(), t_image, t_compression);
+
+    if(!TIFFFlush(tif.get()))
+        throw std::runtime_error("Could not write TIFF directory of " + t_path.string());
+}
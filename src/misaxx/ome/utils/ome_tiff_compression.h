@@ -0,0 +1,113 @@
+/**
+ * Copyright by Ruman Gerst
+ * Research Group Applied Systems Biology - Head: Prof. Dr. Marc Thilo Figge
+ * https://www.leibniz-hki.de/en/applied-systems-biology.html
+ * HKI-Center for Systems Biology of Infection
+ * Leibniz Institute for Natural Product Research and Infection Biology - Hans Knöll Insitute (HKI)
+ * Adolf-Reichwein-Straße 23, 07745 Jena, Germany
+ *
+ * This code is licensed under BSD 2-Clause
+ * See the LICENSE file provided with this code for the full license.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <boost/filesystem.hpp>
+#include <opencv2/opencv.hpp>
+#include <tiffio.h>
+#include "ome_worker_pool.h"
+
+namespace misaxx::ome {
+
+    /**
+     * Compression codecs that can be used for written TIFFs
+     */
+    enum class ome_tiff_codec {
+        none,
+        lzw,
+        deflate,
+        zstd
+    };
+
+    /**
+     * Compression settings of written TIFFs
+     */
+    struct ome_tiff_compression {
+        ome_tiff_codec codec = ome_tiff_codec::none;
+        /**
+         * Compression level (deflate: 1-9, zstd: 1-22). If zero, the default level of the codec is used.
+         */
+        int level = 0;
+        /**
+         * If true, horizontal differencing (floating point differencing for floating point images) is applied before compression
+         */
+        bool predictor = false;
+
+        ome_tiff_compression() = default;
+
+        explicit ome_tiff_compression(ome_tiff_codec t_codec, int t_level = 0, bool t_predictor = false);
+
+        bool is_enabled() const;
+
+        /**
+         * Returns true if libtiff can encode the codec
+         * @return
+         */
+        bool is_supported() const;
+
+        /**
+         * Parses a codec name (none, lzw, deflate or zstd)
+         * @param t_name
+         * @return
+         */
+        static ome_tiff_codec parse_codec(const std::string &t_name);
+    };
+
+    /**
+     * Returns the libtiff compression scheme of a codec
+     * @param codec
+     * @return -1 if libtiff does not know the codec
+     */
+    extern int ome_tiff_get_compression_scheme(ome_tiff_codec codec);
+
+    /**
+     * Sets the compression, predictor and compression level of the current directory
+     * @param t_tif TIFF that is opened for writing
+     * @param t_opencv_depth OpenCV depth of the written image
+     * @param t_compression
+     */
+    extern void ome_tiff_set_compression_fields(TIFF *t_tif, int t_opencv_depth, const ome_tiff_compression &t_compression);
+
+    /**
+     * Returns the OpenCV depth of TIFF samples
+     * @param t_bits_per_sample
+     * @param t_sample_format
+     * @return -1 if OpenCV does not support the samples
+     */
+    extern int ome_tiff_get_opencv_depth(uint16_t t_bits_per_sample, uint16_t t_sample_format);
+
+    /**
+     * Sets the fields of the current directory and writes the image data in strips or tiles.
+     * The directory itself is not written.
+     * If compression is enabled and a worker pool is provided, the strips or tiles are compressed by the calling thread
+     * and the pool in parallel and written in order.
+     * @param t_tif TIFF that is opened for writing
+     * @param t_image
+     * @param t_compression
+     * @param t_tile_size If larger than zero, the image is stored in square tiles of this size. Must be a multiple of 16.
+     * @param t_workers Pool that compresses strips or tiles. Must not be called from a task of this pool.
+     */
+    extern void ome_tiff_write_image(TIFF *t_tif, const cv::Mat &t_image, const ome_tiff_compression &t_compression,
+            uint32_t t_tile_size = 0, ome_worker_pool *t_workers = nullptr);
+
+    /**
+     * Writes an image as standard TIFF with the compression settings.
+     * The result can be read with misaxx::imaging::utils::tiffread
+     * @param t_image
+     * @param t_path
+     * @param t_compression
+     */
+    extern void ome_tiff_write_compressed(const cv::Mat &t_image, const boost::filesystem::path &t_path, const ome_tiff_compression &t_compression);
+}
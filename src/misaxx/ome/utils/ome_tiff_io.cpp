@@ -13,16 +13,31 @@
 #include <src/misaxx/ome/utils/ome_tiff_io.h>
 #include <misaxx/ome/descriptions/misa_ome_plane_description.h>
 #include <misaxx/core/utils/string.h>
-#include <misaxx/imaging/utils/tiffio.h>
-#include <ome/files/out/OMETIFFWriter.h>
 #include <ome/files/in/OMETIFFReader.h>
 #include <ome/xml/meta/Convert.h>
 #include <misaxx/ome/utils/ome_helpers.h>
 #include <ome/files/MetadataTools.h>
 #include <opencv2/opencv.hpp>
+#include <boost/crc.hpp>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <algorithm>
+#include <deque>
+#include <numeric>
+#include <future>
+#include <thread>
 #include "ome_to_opencv.h"
-#include "opencv_to_ome.h"
-#include "ome_to_ome.h"
+#include "ome_tiff_patch.h"
+#include "ome_plane_lru.h"
+#include "ome_tiff_mapping.h"
+#include "ome_tiff_compression.h"
+#include "ome_write_buffer.h"
+#include "ome_tiff_pyramid.h"
+#include "ome_tiff_io_statistics.h"
+#include "ome_tiff_writer.h"
+#include "ome_pixel_buffer_pool.h"
+#include "ome_worker_pool.h"
 
 namespace {
     /**
@@ -40,6 +55,21 @@ namespace {
             return meta;
         }
     };
+
+    /**
+     * Identifies the dataset of an OME TIFF that is created from the metadata, so its write buffer is only
+     * restored by runs that create the same OME TIFF
+     * @param t_metadata
+     * @return Empty if there is no metadata
+     */
+    std::string get_write_buffer_dataset(const std::shared_ptr<::ome::xml::meta::OMEXMLMetadata> &t_metadata) {
+        if(!static_cast<bool>(t_metadata))
+            return std::string();
+        const std::string xml = t_metadata->dumpXML();
+        boost::crc_32_type crc;
+        crc.process_bytes(xml.data(), xml.size());
+        return std::to_string(crc.checksum()) + "-" + std::to_string(xml.size());
+    }
 }
 
 namespace misaxx::ome {
@@ -48,9 +78,9 @@ namespace misaxx::ome {
     public:
 
         using tiff_reader_type = std::shared_ptr<::ome::files::in::OMETIFFReader>;
-        using tiff_writer_type = std::shared_ptr<::ome::files::out::OMETIFFWriter>;
+        using tiff_writer_type = std::shared_ptr<ome_tiff_writer>;
 
-        ome_tiff_io_impl() = default;
+        ome_tiff_io_impl();
 
         /**
          * Opens an existing OME TIFF file
@@ -63,21 +93,49 @@ namespace misaxx::ome {
          *  If the file already exists, the metadata is loaded from the file instead.
          * @param t_path
          * @param t_metadata
+         * @param t_write_buffer_format
          */
         explicit ome_tiff_io_impl(boost::filesystem::path t_path,
-        std::shared_ptr<::ome::xml::meta::OMEXMLMetadata> t_metadata);
+        std::shared_ptr<::ome::xml::meta::OMEXMLMetadata> t_metadata,
+        ome_write_buffer_format t_write_buffer_format);
 
         /**
          * Opens an existing OME TIFF file or creates a new one based on the reference
          * @param t_path
          * @param t_reference
+         * @param t_write_buffer_format
          */
-        explicit ome_tiff_io_impl(boost::filesystem::path t_path, const ome_tiff_io &t_reference);
+        explicit ome_tiff_io_impl(boost::filesystem::path t_path, const ome_tiff_io &t_reference,
+                ome_write_buffer_format t_write_buffer_format);
+
+        ~ome_tiff_io_impl();
 
         void write_plane(const cv::Mat &image, const misa_ome_plane_description &index);
 
         cv::Mat read_plane(const misa_ome_plane_description &index) const;
 
+        void read_plane(const misa_ome_plane_description &index, cv::Mat &dst) const;
+
+        cv::Mat read_plane_region(const misa_ome_plane_description &index, const cv::Rect &region) const;
+
+        std::vector<cv::Mat> read_planes(const std::vector<misa_ome_plane_description> &indices) const;
+
+        /**
+         * Reads multiple planes into the destinations. Empty destinations are allocated.
+         * Other destinations must have the size and type of their plane.
+         * @param indices the planes
+         * @param destinations one destination per plane
+         */
+        void read_planes(const std::vector<misa_ome_plane_description> &indices, std::vector<cv::Mat> &destinations) const;
+
+        cv::Mat read_volume(::ome::files::dimension_size_type series, ::ome::files::dimension_size_type c, ::ome::files::dimension_size_type t) const;
+
+        void write_volume(const cv::Mat &volume, ::ome::files::dimension_size_type series, ::ome::files::dimension_size_type c, ::ome::files::dimension_size_type t);
+
+        cv::Mat read_plane_level(const misa_ome_plane_description &index, size_t level) const;
+
+        bool is_buffered(const misa_ome_plane_description &index) const;
+
         /**
          * Thread-safe access to the metadata
          * @return
@@ -91,6 +149,8 @@ namespace misaxx::ome {
          */
         void close(bool remove_write_buffer = true);
 
+        const ome_tiff_series_dimensions &get_dimensions(::ome::files::dimension_size_type series) const;
+
         /**
          * The number of image series
          * @return
@@ -142,9 +202,68 @@ namespace misaxx::ome {
         bool compression_is_enabled() const;
 
         void set_compression(bool enabled);
+
+        const ome_tiff_compression &get_compression() const;
+
+        void set_compression(ome_tiff_compression compression);
+
+        bool direct_writing_is_enabled() const;
+
+        void set_direct_writing(bool enabled);
+
+        ::ome::files::dimension_size_type get_tile_size() const;
+
+        void set_tile_size(::ome::files::dimension_size_type tile_size);
+
+        size_t get_num_threads() const;
+
+        void set_num_threads(size_t num_threads);
+
+        size_t get_prefetch_depth() const;
+
+        void set_prefetch_depth(size_t depth);
+
+        size_t get_prefetch_limit() const;
+
+        void set_prefetch_limit(size_t limit);
+
+        bool memory_mapping_is_enabled() const;
+
+        void set_memory_mapping(bool enabled);
+
+        ome_write_buffer_format get_write_buffer_format() const;
+
+        void set_write_buffer_format(ome_write_buffer_format format);
+
+        /**
+         * Restores the write buffer of a previous run that was interrupted before the OME TIFF was created.
+         * Planes that are not within the dimensions of the OME TIFF or do not match its plane size and pixel type are ignored.
+         * @return Number of restored planes
+         */
+        size_t restore_write_buffer();
+
+        size_t get_pyramid_levels() const;
+
+        void set_pyramid_levels(size_t levels);
+
+        ome_tiff_io_statistics get_statistics() const;
+
+        void reset_statistics();
+
+        size_t get_buffer_pool_capacity() const;
+
+        void set_buffer_pool_capacity(size_t capacity);
         
     private:
-        bool m_enable_compression = false;
+        ome_tiff_compression m_compression;
+        bool m_enable_direct_writing = false;
+        ::ome::files::dimension_size_type m_tile_size = 0;
+        size_t m_num_threads = get_default_num_threads();
+        size_t m_prefetch_depth = 0;
+        size_t m_prefetch_limit = 0;
+        bool m_enable_memory_mapping = false;
+        ome_write_buffer_format m_write_buffer_format = ome_write_buffer_format::files;
+        size_t m_pyramid_levels = 0;
 
         /**
          * Path of the TIFF that is read / written
@@ -152,26 +271,286 @@ namespace misaxx::ome {
         mutable boost::filesystem::path m_path;
 
         /**
-         * Because of limitations to OMETIFFWriter, we buffer any output TIFF in a separate directory
+         * Identifies the metadata the OME TIFF was created from. Passed to the write buffer.
          */
-        mutable std::map<misa_ome_plane_description, boost::filesystem::path> m_write_buffer;
+        std::string m_write_buffer_dataset;
+
+        /**
+         * Planes are written into the OME TIFF in storage order, so we buffer any output TIFF in a separate directory
+         */
+        std::unique_ptr<ome_write_buffer> m_write_buffer;
+
+        /**
+         * Reduced resolution levels of the planes that were written by the writer.
+         * They are stored into the OME TIFF once the writer is closed.
+         */
+        mutable std::vector<std::unique_ptr<ome_write_buffer>> m_pyramid_buffers;
+
+        /**
+         * Writer that streams planes into the OME TIFF. Only open during close_writer or in direct writing mode.
+         */
+        mutable tiff_writer_type m_writer;
+
+        /**
+         * Series and plane index of the next plane that is expected by the writer
+         */
+        mutable ::ome::files::dimension_size_type m_writer_series = 0;
+        mutable ::ome::files::dimension_size_type m_writer_plane = 0;
+
+        /**
+         * If true, the write buffer contains modified planes of an existing OME TIFF
+         */
+        mutable bool m_write_buffer_updates_existing = false;
 
         mutable std::shared_ptr<custom_ome_tiff_reader> m_reader;
+
+        /**
+         * Memory mapping of the file. Only available while the main reader is open.
+         */
+        mutable std::shared_ptr<ome_tiff_mapping> m_mapping;
+
+        /**
+         * Reduced resolution levels stored in the file. Loaded on the first access while the main reader is open.
+         */
+        mutable std::shared_ptr<ome_tiff_pyramid> m_pyramid;
+        mutable bool m_pyramid_loaded = false;
+        mutable std::mutex m_pyramid_mutex;
         mutable std::shared_ptr<::ome::xml::meta::OMEXMLMetadata> m_metadata;
         mutable std::shared_mutex m_mutex;
 
+        /**
+         * Dimensions of each series. Created once the metadata is available and not modified afterwards.
+         */
+        mutable std::vector<ome_tiff_series_dimensions> m_dimensions;
+        mutable std::atomic<bool> m_has_dimensions { false };
+        mutable std::once_flag m_require_dimensions_flag;
+
+        /**
+         * Idle readers that can be borrowed by read_plane, grouped by the series they are located at.
+         * Each reader is only used by one thread at a time, which allows planes to be read concurrently.
+         */
+        mutable std::map<::ome::files::dimension_size_type, std::vector<std::shared_ptr<custom_ome_tiff_reader>>> m_reader_pool;
+        mutable std::mutex m_reader_pool_mutex;
+
+        /**
+         * Plane that is decoded in the background by the prefetch worker.
+         * Abandoned tasks are cancelled and their result is dropped without waiting for it.
+         */
+        struct prefetch_task {
+            misa_ome_plane_description location;
+            std::promise<cv::Mat> promise;
+            std::shared_future<cv::Mat> result;
+            std::atomic<bool> cancelled { false };
+        };
+
+        /**
+         * Planes that are decoded in the background, because they will be read next
+         */
+        mutable std::map<misa_ome_plane_description, std::shared_ptr<prefetch_task>> m_prefetched;
+
+        /**
+         * Planes that were not decoded yet in the order they are decoded by the prefetch worker
+         */
+        mutable std::deque<std::shared_ptr<prefetch_task>> m_prefetch_queue;
+
+        /**
+         * Decodes the queued planes. Started on the first prefetch.
+         */
+        mutable std::thread m_prefetch_thread;
+
+        /**
+         * True while the prefetch worker decodes a plane. Guarded by m_prefetch_mutex.
+         */
+        mutable bool m_prefetch_busy = false;
+        mutable bool m_prefetch_stopping = false;
+        mutable std::condition_variable m_prefetch_changed;
+        mutable std::mutex m_prefetch_mutex;
+
+        mutable ome_tiff_io_statistics_recorder m_statistics;
+
+        /**
+         * Locks m_mutex and records the time spent waiting for it
+         * @tparam Lock
+         * @param lock
+         */
+        template<class Lock> void lock_timed(Lock &lock) const {
+            const auto timer = m_statistics.time(ome_tiff_io_timer::lock_wait);
+            lock.lock();
+        }
+
+        /**
+         * Decodes a region of a plane with an OME TIFF reader
+         * @param reader
+         * @param index
+         * @param region
+         * @return
+         */
+        cv::Mat decode_plane(const custom_ome_tiff_reader &reader, const misa_ome_plane_description &index, const cv::Rect &region) const;
+
+        /**
+         * Decodes a region of a plane with an OME TIFF reader into the destination
+         * @param reader
+         * @param index
+         * @param region
+         * @param dst Allocated if it does not have the size and type of the region
+         */
+        void decode_plane(const custom_ome_tiff_reader &reader, const misa_ome_plane_description &index, const cv::Rect &region, cv::Mat &dst) const;
+
+        /**
+         * OpenCV type of the planes of a channel
+         * @param series
+         * @param c
+         * @return
+         */
+        int get_opencv_type(::ome::files::dimension_size_type series, ::ome::files::dimension_size_type c) const;
+
+        /**
+         * Reader that is borrowed from the reader pool and returned on destruction.
+         * The reader is located at the requested series. Readers that are already located at the series are preferred.
+         */
+        struct borrowed_reader {
+            const ome_tiff_io_impl &io;
+            std::shared_ptr<custom_ome_tiff_reader> reader;
+
+            explicit borrowed_reader(const ome_tiff_io_impl &t_io, ::ome::files::dimension_size_type t_series);
+
+            ~borrowed_reader();
+        };
+
+        std::shared_ptr<custom_ome_tiff_reader> create_reader() const;
+
+        /**
+         * Prepares reading a plane while the shared lock is held. Opens the main reader if the plane is not buffered.
+         * The lock might be temporarily released to open the main reader.
+         * @param index the plane
+         * @param lock locked shared lock of m_mutex
+         * @return True if the plane is located in the write buffer
+         */
+        bool prepare_read(const misa_ome_plane_description &index, std::shared_lock<std::shared_mutex> &lock) const;
+
+        /**
+         * Reads data of a plane either from the write buffer, the memory mapping or via a borrowed reader
+         * @param index the plane
+         * @param from_write_buffer Function that reads from the write buffer
+         * @param from_mapping Function that reads from the memory mapping
+         * @param from_reader Function that reads from an OME TIFF reader
+         * @return
+         */
+        template<class BufferFunction, class MappingFunction, class ReaderFunction>
+        cv::Mat read_plane_with(const misa_ome_plane_description &index, const BufferFunction &from_write_buffer,
+                const MappingFunction &from_mapping, const ReaderFunction &from_reader) const;
+
+        /**
+         * Reads a plane without looking into the prefetched planes
+         * @param index
+         * @return
+         */
+        cv::Mat read_plane_uncached(const misa_ome_plane_description &index) const;
+
+        /**
+         * Starts decoding the planes that follow the location in the background
+         * @param t_location the plane that was just read
+         * @param plane_bytes expected size of a decoded plane
+         */
+        void prefetch_after(const misa_ome_plane_description &t_location, size_t plane_bytes) const;
+
+        /**
+         * Removes the prefetched plane
+         * @param t_location
+         * @return The result of the prefetching task or an invalid future if the plane is not prefetched
+         */
+        std::shared_future<cv::Mat> take_prefetched(const misa_ome_plane_description &t_location) const;
+
+        /**
+         * Removes the prefetched plane and cancels its decoding if it did not start yet
+         * @param t_location
+         */
+        void cancel_prefetched(const misa_ome_plane_description &t_location) const;
+
+        /**
+         * Cancels all prefetched planes and removes them
+         * @param wait If true, waits until the prefetch worker finished its current plane. m_mutex must not be locked in this case.
+         */
+        void discard_prefetched(bool wait) const;
+
+        /**
+         * Decodes queued planes until prefetching is stopped
+         */
+        void prefetch_worker() const;
+
+        /**
+         * Cancels all prefetched planes and stops the prefetch worker. m_mutex must not be locked.
+         */
+        void stop_prefetching() const;
+
+        /**
+         * Moves the location to the next plane in the order series, Z, C, T
+         * @param t_location
+         * @return False if there is no next plane
+         */
+        bool get_next_plane(misa_ome_plane_description &t_location) const;
+
+        /**
+         * Copies the dimensions of all series from the metadata
+         */
+        void load_dimensions() const;
+
+        /**
+         * Loads the metadata if the dimensions are not available yet
+         */
+        void require_dimensions() const;
+
         void open_reader() const;
 
         void close_reader() const;
 
+        /**
+         * Returns the reduced resolution levels stored in the file. m_mutex must be locked and the main reader must be open.
+         * @return nullptr if the file does not contain reduced resolution levels
+         */
+        std::shared_ptr<ome_tiff_pyramid> get_pyramid() const;
+
         void close_writer(bool remove_write_buffer) const;
 
+        tiff_writer_type create_writer() const;
+
         /**
-         * Returns the write buffer path for a location
+         * Writes the modified planes of an existing OME TIFF into the file without rewriting the other planes
+         * @param remove_write_buffer
+         * @return False if the OME TIFF cannot be updated in place
+         */
+        bool update_existing_planes(bool remove_write_buffer) const;
+
+        /**
+         * Copies all planes of the existing OME TIFF that were not modified into the write buffer
+         */
+        void buffer_existing_planes() const;
+
+        /**
+         * Writes a plane into the writer. Planes must be written in the order they are stored within the OME TIFF.
+         * @param image
+         * @param t_location
+         */
+        void write_plane_to_writer(const cv::Mat &image, const misa_ome_plane_description &t_location) const;
+
+        /**
+         * Streams buffered planes into the writer until a plane is missing
+         */
+        void flush_write_buffer_to_writer() const;
+
+        /**
+         * Returns true if the plane was already streamed into the OME TIFF by the writer
+         * @param t_location
+         * @return
+         */
+        bool is_written_to_writer(const misa_ome_plane_description &t_location) const;
+
+        /**
+         * Index of the plane within its series as stored in the OME TIFF
          * @param t_location
          * @return
          */
-        boost::filesystem::path get_write_buffer_path(const misa_ome_plane_description &t_location) const;
+        ::ome::files::dimension_size_type get_plane_index(const misa_ome_plane_description &t_location) const;
 
         /**
         * Thread-safe access to the managed reader
@@ -179,35 +558,78 @@ namespace misaxx::ome {
         * @return
         */
         tiff_reader_type get_reader(const misa_ome_plane_description &t_location) const;
+
+        /**
+         * Threads that decode and encode planes together with the calling thread.
+         * All parallel work of this IO is run by this pool, so its tasks never submit further tasks.
+         */
+        mutable std::shared_ptr<ome_worker_pool> m_workers;
+        mutable std::mutex m_workers_mutex;
+
+        /**
+         * Returns the worker pool of this IO, which has get_num_threads() - 1 threads
+         * @return
+         */
+        std::shared_ptr<ome_worker_pool> get_workers() const;
+
+        /**
+         * Number of threads that is used if no number is set
+         * @return
+         */
+        static size_t get_default_num_threads();
     };
 }
 
 using namespace misaxx::ome;
 
 
-ome_tiff_io_impl::ome_tiff_io_impl(boost::filesystem::path t_path) : m_path(std::move(t_path)) {
+ome_tiff_io_impl::ome_tiff_io_impl() : m_write_buffer(ome_write_buffer::create(ome_write_buffer_format::files, m_path)) {
+
+}
+
+ome_tiff_io_impl::ome_tiff_io_impl(boost::filesystem::path t_path) : m_path(std::move(t_path)),
+        m_write_buffer(ome_write_buffer::create(ome_write_buffer_format::files, m_path)) {
     if (!boost::filesystem::exists(m_path)) {
         throw std::runtime_error("Cannot read from non-existing file " + m_path.string());
     }
 }
 
 ome_tiff_io_impl::ome_tiff_io_impl(boost::filesystem::path t_path,
-                                     std::shared_ptr<::ome::xml::meta::OMEXMLMetadata> t_metadata) : m_path(
-        std::move(t_path)), m_metadata(std::move(t_metadata)) {
+                                     std::shared_ptr<::ome::xml::meta::OMEXMLMetadata> t_metadata,
+                                     ome_write_buffer_format t_write_buffer_format) :
+        m_write_buffer_format(t_write_buffer_format), m_path(std::move(t_path)),
+        m_write_buffer_dataset(get_write_buffer_dataset(t_metadata)),
+        m_write_buffer(ome_write_buffer::create(t_write_buffer_format, m_path, m_write_buffer_dataset)),
+        m_metadata(std::move(t_metadata)) {
     // We can load metadata from the file if it exists
     if (boost::filesystem::exists(m_path)) {
         m_metadata.reset();
     }
+    else if(static_cast<bool>(m_metadata)) {
+        load_dimensions();
+    }
+}
+
+ome_tiff_io_impl::ome_tiff_io_impl(boost::filesystem::path t_path, const ome_tiff_io &t_reference,
+                                   ome_write_buffer_format t_write_buffer_format)
+        : ome_tiff_io_impl(std::move(t_path), t_reference.get_metadata(), t_write_buffer_format) {
 }
 
-ome_tiff_io_impl::ome_tiff_io_impl(boost::filesystem::path t_path, const ome_tiff_io &t_reference)
-        : ome_tiff_io_impl(std::move(t_path), t_reference.get_metadata()) {
+ome_tiff_io_impl::~ome_tiff_io_impl() {
+    // The prefetch worker accesses this IO
+    stop_prefetching();
 }
 
 ome_tiff_io_impl::tiff_reader_type
 ome_tiff_io_impl::get_reader(const misa_ome_plane_description &t_location) const {
     if(!static_cast<bool>(m_reader)) {
-        if(!m_write_buffer.empty()) {
+        // Closing the writer would finish the OME TIFF before all planes are written
+        if(static_cast<bool>(m_writer)) {
+            throw std::runtime_error("Plane " + misaxx::utils::to_string(t_location) + " was not written into " + m_path.string() +
+                                     " yet and cannot be read while planes are written directly into the OME TIFF!");
+        }
+        // Modified planes of an existing file do not prevent reading the other planes
+        if(!m_write_buffer->empty() && !m_write_buffer_updates_existing) {
             close_writer(true);
         }
         open_reader();
@@ -215,49 +637,261 @@ ome_tiff_io_impl::get_reader(const misa_ome_plane_description &t_location) const
     return m_reader;
 }
 
-boost::filesystem::path
-ome_tiff_io_impl::get_write_buffer_path(const misa_ome_plane_description &t_location) const {
-    return m_path.parent_path() / "__misa_ome_write_buffer__" / (m_path.filename().string() + "_" + misaxx::utils::to_string(t_location) + ".ome.tif");
-}
-
 void ome_tiff_io_impl::close_writer(bool remove_write_buffer) const {
+    const auto timer = m_statistics.time(ome_tiff_io_timer::close_writer);
+    if(m_write_buffer_updates_existing) {
+        m_write_buffer_updates_existing = false;
+        // Reduced resolution levels are only created if the OME TIFF is rewritten
+        if(get_pyramid_levels() == 0 && update_existing_planes(remove_write_buffer))
+            return;
+        buffer_existing_planes();
+    }
+
     std::cout << "[MISA++ OME] Writing results as OME TIFF " << m_path << " ... " << "\n";
     // Save the write buffer files into the path
-    auto writer = std::make_shared<::ome::files::out::OMETIFFWriter>();
-    auto metadata = std::static_pointer_cast<::ome::xml::meta::MetadataRetrieve>(m_metadata);
-    writer->setMetadataRetrieve(metadata);
-    writer->setBigTIFF(true);
-    writer->setId(m_path);
-    const auto compression_types = writer->getCompressionTypes();
-    if(compression_is_enabled() && compression_types.find("LZW") != compression_types.end()) {
-        writer->setCompression("LZW");
+    if(!static_cast<bool>(m_writer)) {
+        m_writer = create_writer();
+    }
+
+    // The writer expects the planes in the order they are stored within the OME TIFF
+    std::vector<misa_ome_plane_description> buffered = m_write_buffer->get_planes();
+    std::sort(buffered.begin(), buffered.end(), [this](const auto &lhs, const auto &rhs) {
+        return std::make_pair(lhs.series, get_plane_index(lhs)) < std::make_pair(rhs.series, get_plane_index(rhs));
+    });
+
+    // Buffered planes are decoded by the worker pool, while this thread writes them in order.
+    // The strips or tiles of each plane are compressed by this thread and the same pool.
+    const auto workers = get_workers();
+    std::deque<std::future<cv::Mat>> decoded;
+    size_t next_decoded = 0;
+    for(size_t i = 0; i < buffered.size(); ++i) {
+        while(next_decoded < buffered.size() && next_decoded < i + get_num_threads()) {
+            decoded.emplace_back(workers->submit([this, location = buffered[next_decoded]]() {
+                const auto read_timer = m_statistics.time(ome_tiff_io_timer::write_buffer_read);
+                cv::Mat plane = ome_pixel_buffer_pool::global().get_mat(static_cast<int>(get_size_y(location.series)), static_cast<int>(get_size_x(location.series)),
+                        get_opencv_type(location.series, location.c));
+                m_write_buffer->read_into(location, plane);
+                return plane;
+            }));
+            ++next_decoded;
+        }
+
+        const auto &location = buffered[i];
+        std::cout << "[MISA++ OME] Writing results as OME TIFF " << m_path << " ... " << location << "\n";
+        cv::Mat tmp = decoded.front().get();
+        decoded.pop_front();
+        write_plane_to_writer(tmp, location);
+    }
+
+    m_writer->close();
+    m_writer.reset();
+    m_writer_series = 0;
+    m_writer_plane = 0;
+
+    if(!m_pyramid_buffers.empty()) {
+        std::cout << "[MISA++ OME] Writing reduced resolution levels of " << m_path << " ... " << "\n";
+        ome_tiff_write_pyramid(m_path, m_pyramid_buffers.front()->get_planes(), m_pyramid_buffers.size(), get_compression(),
+                [this](const misa_ome_plane_description &location, size_t level) {
+            return m_pyramid_buffers.at(level - 1)->read(location);
+        });
+        for(const auto &buffer : m_pyramid_buffers) {
+            buffer->clear(true);
+        }
+        m_pyramid_buffers.clear();
     }
 
-    for(const auto &kv : m_write_buffer) {
-        std::cout << "[MISA++ OME] Writing results as OME TIFF " << m_path << " ... " << kv.first << "\n";
-        cv::Mat tmp = misaxx::imaging::utils::tiffread(kv.second);
-        opencv_to_ome(tmp, *writer, kv.first);
+    // Remove write buffer if requested
+    m_write_buffer->clear(remove_write_buffer);
+}
+
+bool ome_tiff_io_impl::update_existing_planes(bool remove_write_buffer) const {
+    const std::vector<misa_ome_plane_description> planes = m_write_buffer->get_planes();
+    std::cout << "[MISA++ OME] Updating " << planes.size() << " planes of existing OME TIFF " << m_path << " ... " << "\n";
+
+    const bool success = ome_tiff_patch_planes(m_path, *m_metadata, planes, get_compression(), [this](const misa_ome_plane_description &location) {
+        return m_write_buffer->read(location);
+    });
+    if(!success) {
+        std::cout << "[MISA++ OME] Updating " << planes.size() << " planes of existing OME TIFF " << m_path << " ... not possible. The OME TIFF is rewritten." << "\n";
+        return false;
+    }
 
-        // Remove write buffer if requested
-        if(remove_write_buffer) {
-            boost::filesystem::remove(kv.second);
+    m_write_buffer->clear(remove_write_buffer);
+    return true;
+}
+
+void ome_tiff_io_impl::buffer_existing_planes() const {
+    auto reader = create_reader();
+    for(size_t series = 0; series < reader->getSeriesCount(); ++series) {
+        reader->setSeries(series);
+        const auto size_Z = reader->getSizeZ();
+        const auto size_C = reader->getEffectiveSizeC();
+        const auto size_T = reader->getSizeT();
+
+        for(size_t z = 0; z < size_Z; ++z) {
+            for(size_t c = 0; c < size_C; ++c) {
+                for (size_t t = 0; t < size_T; ++t) {
+                    const misa_ome_plane_description location(series, z, c, t);
+                    if(m_write_buffer->contains(location))
+                        continue;
+                    std::cout << "[MISA++ OME] Preparing write mode for existing OME TIFF " << m_path << " ... writing plane " << location << "\n";
+
+                    cv::Mat tmp = ome_to_opencv(*reader, location);
+                    m_write_buffer->write(location, tmp, ome_tiff_compression());
+                }
+            }
         }
     }
+    reader->close();
+}
+
+ome_tiff_io_impl::tiff_writer_type ome_tiff_io_impl::create_writer() const {
+    // The OME Files writer only applies the compression codec, so the OME TIFF is written with libtiff
+    return std::make_shared<ome_tiff_writer>(m_path, m_metadata, get_compression(), get_tile_size(), get_workers());
+}
+
+void ome_tiff_io_impl::write_plane_to_writer(const cv::Mat &image, const misa_ome_plane_description &t_location) const {
+    m_writer->write_plane(image);
+
+    // Reduced resolution levels are computed while the plane is available and stored after the writer was closed
+    cv::Mat level = image;
+    for(size_t i = 0; i < get_pyramid_levels(); ++i) {
+        if(m_pyramid_buffers.size() <= i) {
+            const boost::filesystem::path level_path = m_path.parent_path() / (m_path.filename().string() + ".level" + std::to_string(i + 1));
+            m_pyramid_buffers.emplace_back(ome_write_buffer::create(ome_write_buffer_format::log, level_path));
+        }
+        level = ome_tiff_downsample(level);
+        m_pyramid_buffers[i]->write(t_location, level, ome_tiff_compression());
+    }
+
+    // Move to the next plane
+    m_writer_series = t_location.series;
+    m_writer_plane = get_plane_index(t_location) + 1;
+    if(m_writer_plane >= get_num_planes(m_writer_series)) {
+        ++m_writer_series;
+        m_writer_plane = 0;
+    }
+}
+
+void ome_tiff_io_impl::flush_write_buffer_to_writer() const {
+    while(m_writer_series < get_num_series()) {
+        const auto zct = helpers::get_plane_zct(*m_metadata, m_writer_series, m_writer_plane);
+        const misa_ome_plane_description location(m_writer_series, zct[0], zct[1], zct[2]);
+        if(!m_write_buffer->contains(location))
+            break;
+        cv::Mat image;
+        {
+            const auto timer = m_statistics.time(ome_tiff_io_timer::write_buffer_read);
+            image = m_write_buffer->read(location);
+        }
+        write_plane_to_writer(image, location);
+        m_write_buffer->remove(location);
+    }
+}
+
+bool ome_tiff_io_impl::is_written_to_writer(const misa_ome_plane_description &t_location) const {
+    if(!static_cast<bool>(m_writer))
+        return false;
+    return t_location.series < m_writer_series || (t_location.series == m_writer_series && get_plane_index(t_location) < m_writer_plane);
+}
 
-    writer->close();
-    m_write_buffer.clear();
+::ome::files::dimension_size_type ome_tiff_io_impl::get_plane_index(const misa_ome_plane_description &t_location) const {
+    using namespace ::ome::xml::model::enums;
+    const auto &dimensions = get_dimensions(t_location.series);
+    const auto z = t_location.z;
+    const auto c = t_location.c;
+    const auto t = t_location.t;
+    switch(dimensions.dimension_order) {
+        case DimensionOrder::XYZCT:
+            return z + dimensions.size_Z * (c + dimensions.size_C * t);
+        case DimensionOrder::XYZTC:
+            return z + dimensions.size_Z * (t + dimensions.size_T * c);
+        case DimensionOrder::XYCZT:
+            return c + dimensions.size_C * (z + dimensions.size_Z * t);
+        case DimensionOrder::XYCTZ:
+            return c + dimensions.size_C * (t + dimensions.size_T * z);
+        case DimensionOrder::XYTZC:
+            return t + dimensions.size_T * (z + dimensions.size_Z * c);
+        case DimensionOrder::XYTCZ:
+            return t + dimensions.size_T * (c + dimensions.size_C * z);
+        default:
+            throw std::runtime_error("Unsupported dimension order!");
+    }
 }
 
 void ome_tiff_io_impl::close_reader() const {
+    std::lock_guard<std::mutex> pool_lock(m_reader_pool_mutex);
+    for(const auto &kv : m_reader_pool) {
+        for(const auto &reader : kv.second) {
+            if(reader != m_reader) {
+                reader->close();
+            }
+        }
+    }
+    m_reader_pool.clear();
+    m_mapping.reset();
+    {
+        std::lock_guard<std::mutex> pyramid_lock(m_pyramid_mutex);
+        m_pyramid.reset();
+        m_pyramid_loaded = false;
+    }
     m_reader->close();
     m_reader.reset();
 }
 
+std::shared_ptr<ome_tiff_pyramid> ome_tiff_io_impl::get_pyramid() const {
+    std::lock_guard<std::mutex> pyramid_lock(m_pyramid_mutex);
+    if(!m_pyramid_loaded) {
+        m_pyramid = ome_tiff_pyramid::open(m_path, *m_metadata);
+        m_pyramid_loaded = true;
+    }
+    return m_pyramid;
+}
+
+std::shared_ptr<custom_ome_tiff_reader> ome_tiff_io_impl::create_reader() const {
+    auto reader = std::make_shared<custom_ome_tiff_reader>();
+    reader->setMetadataFiltered(false);
+    reader->setGroupFiles(true);
+    reader->setId(m_path);
+    return reader;
+}
+
+ome_tiff_io_impl::borrowed_reader::borrowed_reader(const ome_tiff_io_impl &t_io, ::ome::files::dimension_size_type t_series) : io(t_io) {
+    {
+        std::lock_guard<std::mutex> pool_lock(io.m_reader_pool_mutex);
+        auto it = io.m_reader_pool.find(t_series);
+        if(it == io.m_reader_pool.end() || it->second.empty()) {
+            // Move an idle reader from another series
+            it = std::find_if(io.m_reader_pool.begin(), io.m_reader_pool.end(), [](const auto &kv) {
+                return !kv.second.empty();
+            });
+        }
+        if(it != io.m_reader_pool.end()) {
+            reader = std::move(it->second.back());
+            it->second.pop_back();
+        }
+    }
+    // Opening a reader parses the file header. Do this outside of the pool lock.
+    if(!static_cast<bool>(reader)) {
+        reader = io.create_reader();
+    }
+    if(reader->getSeries() != t_series) {
+        reader->setSeries(t_series);
+    }
+}
+
+ome_tiff_io_impl::borrowed_reader::~borrowed_reader() {
+    std::lock_guard<std::mutex> pool_lock(io.m_reader_pool_mutex);
+    io.m_reader_pool[reader->getSeries()].emplace_back(std::move(reader));
+}
+
 void ome_tiff_io_impl::open_reader() const {
-    m_reader = std::make_shared<custom_ome_tiff_reader>();
-    m_reader->setMetadataFiltered(false);
-    m_reader->setGroupFiles(true);
-    m_reader->setId(m_path);
+    m_reader = create_reader();
+    {
+        // The main reader is only used while m_mutex is exclusively locked, so it can be shared with the pool
+        std::lock_guard<std::mutex> pool_lock(m_reader_pool_mutex);
+        m_reader_pool[m_reader->getSeries()].push_back(m_reader);
+    }
 
     // INFO: This would be the proper way of loading the metadata, but it does not work
     // For example PhysicalSize properties are missing
@@ -273,16 +907,64 @@ void ome_tiff_io_impl::open_reader() const {
 
     if(!static_cast<bool>(m_metadata)) {
         m_metadata = m_reader->get_xml_metadata(); // Copy the XML data to be sure
+        load_dimensions();
+    }
+
+    if(memory_mapping_is_enabled()) {
+        m_mapping = ome_tiff_mapping::open(m_path, *m_metadata);
     }
 }
 
+void ome_tiff_io_impl::load_dimensions() const {
+    std::vector<ome_tiff_series_dimensions> dimensions;
+    for(size_t series = 0; series < m_metadata->getImageCount(); ++series) {
+        ome_tiff_series_dimensions series_dimensions;
+        series_dimensions.size_X = m_metadata->getPixelsSizeX(series);
+        series_dimensions.size_Y = m_metadata->getPixelsSizeY(series);
+        series_dimensions.size_Z = m_metadata->getPixelsSizeZ(series);
+        series_dimensions.size_C = m_metadata->getChannelCount(series);
+        series_dimensions.size_T = m_metadata->getPixelsSizeT(series);
+        series_dimensions.pixel_type = m_metadata->getPixelsType(series);
+        series_dimensions.dimension_order = m_metadata->getPixelsDimensionOrder(series);
+        for(size_t c = 0; c < series_dimensions.size_C; ++c) {
+            series_dimensions.samples_per_pixel.push_back(m_metadata->getChannelSamplesPerPixel(series, c));
+        }
+        dimensions.push_back(std::move(series_dimensions));
+    }
+    m_dimensions = std::move(dimensions);
+    m_has_dimensions.store(true, std::memory_order_release);
+}
+
+void ome_tiff_io_impl::require_dimensions() const {
+    if(m_has_dimensions.load(std::memory_order_acquire))
+        return;
+    // Other threads wait until the first one opened the reader, which loads the metadata and dimensions
+    std::call_once(m_require_dimensions_flag, [this]() {
+        std::unique_lock<std::shared_mutex> lock { m_mutex, std::defer_lock };
+        lock_timed(lock);
+        if(!m_has_dimensions.load(std::memory_order_acquire)) {
+            get_reader(misa_ome_plane_description(0, 0, 0, 0));
+        }
+    });
+    if(!m_has_dimensions.load(std::memory_order_acquire))
+        throw std::runtime_error("Could not load the dimensions of " + m_path.string() + "!");
+}
+
+const ome_tiff_series_dimensions &ome_tiff_io_impl::get_dimensions(::ome::files::dimension_size_type series) const {
+    require_dimensions();
+    if(series >= m_dimensions.size())
+        throw std::runtime_error("The OME TIFF " + m_path.string() + " does not contain series " + std::to_string(series) + "!");
+    return m_dimensions[series];
+}
+
 void ome_tiff_io_impl::close(bool remove_write_buffer) {
+    discard_prefetched(true);
     std::unique_lock<std::shared_mutex> lock(m_mutex, std::defer_lock);
-    lock.lock();
+    lock_timed(lock);
     if(static_cast<bool>(m_reader)) {
         close_reader();
     }
-    if(!m_write_buffer.empty()) {
+    if(!m_write_buffer->empty() || static_cast<bool>(m_writer)) {
         close_writer(remove_write_buffer);
     }
 }
@@ -293,120 +975,416 @@ std::shared_ptr<::ome::xml::meta::OMEXMLMetadata> ome_tiff_io_impl::get_metadata
     }
     else {
         // We are currently reading a file. Open it and fetch the metadata
-        if(!m_write_buffer.empty())
+        if(!m_write_buffer->empty())
             throw std::logic_error("Write buffer is active, but no metadata is set!");
         std::cout << "[MISA++ OME] Locking " << m_path << " to obtain OME XML metadata" << "\n";
         std::unique_lock<std::shared_mutex> lock { m_mutex, std::defer_lock };
-        lock.lock();
+        lock_timed(lock);
         std::cout << "[MISA++ OME] Locking " << m_path << " to obtain OME XML metadata ... successful" << "\n";
         get_reader(misa_ome_plane_description(0, 0, 0, 0));
         return m_metadata;
     }
 }
 
+bool ome_tiff_io_impl::prepare_read(const misa_ome_plane_description &index, std::shared_lock<std::shared_mutex> &lock) const {
+    while(true) {
+        if(m_write_buffer->contains(index)) {
+            return true;
+        }
+        if(is_written_to_writer(index)) {
+            throw std::runtime_error("Plane " + misaxx::utils::to_string(index) + " was already written into " + m_path.string() +
+                                     " and cannot be read until the OME TIFF is closed!");
+        }
+        if(static_cast<bool>(m_reader))
+            return false;
+
+        // Opening the main reader might flush the write buffer and requires exclusive access
+        lock.unlock();
+        {
+            std::unique_lock<std::shared_mutex> wlock { m_mutex, std::defer_lock };
+            lock_timed(wlock);
+            get_reader(index);
+        }
+        lock_timed(lock);
+    }
+}
+
+template<class BufferFunction, class MappingFunction, class ReaderFunction>
+cv::Mat ome_tiff_io_impl::read_plane_with(const misa_ome_plane_description &index, const BufferFunction &from_write_buffer,
+                                          const MappingFunction &from_mapping, const ReaderFunction &from_reader) const {
+    // Fails if the series does not exist
+    get_dimensions(index.series);
+
+    // A shared lock is sufficient for reading, as each thread borrows its own reader
+    std::shared_lock<std::shared_mutex> lock { m_mutex, std::defer_lock };
+    lock_timed(lock);
+
+    if(prepare_read(index, lock)) {
+        return from_write_buffer(*m_write_buffer);
+    }
+
+    if(static_cast<bool>(m_mapping) && m_mapping->contains(index)) {
+        return from_mapping(*m_mapping);
+    }
+
+    borrowed_reader reader(*this, index.series);
+    return from_reader(*reader.reader);
+}
+
 cv::Mat ome_tiff_io_impl::read_plane(const misa_ome_plane_description &index) const {
-    if(index.series != 0)
-        throw std::runtime_error("Only series 0 is currently supported!");
+    cv::Mat result;
+    std::shared_future<cv::Mat> prefetched = take_prefetched(index);
+    if(prefetched.valid()) {
+        try {
+            result = prefetched.get();
+        }
+        catch(...) {
+            // Read the plane again to report the error
+        }
+    }
+    if(result.empty()) {
+        result = read_plane_uncached(index);
+    }
+    m_statistics.add_read(result.total() * result.elemSize());
+    if(get_prefetch_depth() > 0 && get_prefetch_limit() > 0) {
+        prefetch_after(index, result.total() * result.elemSize());
+    }
+    return result;
+}
+
+void ome_tiff_io_impl::read_plane(const misa_ome_plane_description &index, cv::Mat &dst) const {
+    bool from_prefetched = false;
+    std::shared_future<cv::Mat> prefetched = take_prefetched(index);
+    if(prefetched.valid()) {
+        try {
+            const cv::Mat &plane = prefetched.get();
+            if(dst.empty()) {
+                dst = plane;
+                from_prefetched = true;
+            }
+            else if(dst.size() == plane.size() && dst.type() == plane.type()) {
+                plane.copyTo(dst);
+                from_prefetched = true;
+            }
+        }
+        catch(...) {
+            // Read the plane again to report the error
+        }
+    }
+    if(from_prefetched) {
+        m_statistics.add_read(dst.total() * dst.elemSize());
+    }
+    else {
+        // The destination header shares the pixels of dst, so they are decoded in place
+        std::vector<cv::Mat> destinations { dst };
+        read_planes({ index }, destinations);
+        dst = destinations.front();
+    }
+    if(get_prefetch_depth() > 0 && get_prefetch_limit() > 0) {
+        prefetch_after(index, dst.total() * dst.elemSize());
+    }
+}
+
+cv::Mat ome_tiff_io_impl::read_plane_uncached(const misa_ome_plane_description &index) const {
+    return read_plane_with(index, [this, &index](const ome_write_buffer &buffer) {
+        const auto timer = m_statistics.time(ome_tiff_io_timer::write_buffer_read);
+        return buffer.read(index);
+    }, [&index](const ome_tiff_mapping &mapping) {
+        return mapping.read_plane(index);
+    }, [this, &index](const custom_ome_tiff_reader &reader) {
+        return decode_plane(reader, index, cv::Rect(0, 0, static_cast<int>(get_size_x(index.series)), static_cast<int>(get_size_y(index.series))));
+    });
+}
+
+cv::Mat ome_tiff_io_impl::decode_plane(const custom_ome_tiff_reader &reader, const misa_ome_plane_description &index,
+                                       const cv::Rect &region) const {
+    cv::Mat result;
+    decode_plane(reader, index, region, result);
+    return result;
+}
+
+void ome_tiff_io_impl::decode_plane(const custom_ome_tiff_reader &reader, const misa_ome_plane_description &index,
+                                    const cv::Rect &region, cv::Mat &dst) const {
+    const auto channels = reader.getRGBChannelCount(index.c);
+    const auto ome_buffer = ome_pixel_buffer_pool::global().get_ome_buffer(static_cast<::ome::files::dimension_size_type>(region.width),
+            static_cast<::ome::files::dimension_size_type>(region.height), channels, get_dimensions(index.series).pixel_type);
+    {
+        const auto timer = m_statistics.time(ome_tiff_io_timer::decode);
+        reader.openBytes(index.index_within(reader), *ome_buffer,
+                static_cast<::ome::files::dimension_size_type>(region.x),
+                static_cast<::ome::files::dimension_size_type>(region.y),
+                static_cast<::ome::files::dimension_size_type>(region.width),
+                static_cast<::ome::files::dimension_size_type>(region.height));
+    }
+    m_statistics.add_decoded();
+
+    const auto timer = m_statistics.time(ome_tiff_io_timer::conversion);
+    ome_to_opencv(*ome_buffer, region.width, region.height, static_cast<int>(channels), dst);
+}
+
+cv::Mat ome_tiff_io_impl::read_plane_region(const misa_ome_plane_description &index, const cv::Rect &region) const {
+    const auto size_x = static_cast<int>(get_size_x(index.series));
+    const auto size_y = static_cast<int>(get_size_y(index.series));
+    if(region.x < 0 || region.y < 0 || region.width <= 0 || region.height <= 0 || region.x + region.width > size_x || region.y + region.height > size_y) {
+        throw std::runtime_error("The region is not located within the plane " + misaxx::utils::to_string(index) + "!");
+    }
+    cv::Mat result = read_plane_with(index, [this, &index, &region](const ome_write_buffer &buffer) {
+        const auto timer = m_statistics.time(ome_tiff_io_timer::write_buffer_read);
+        return buffer.read_region(index, region);
+    }, [&index, &region](const ome_tiff_mapping &mapping) {
+        return mapping.read_plane_region(index, region);
+    }, [this, &index, &region](const custom_ome_tiff_reader &reader) {
+        return decode_plane(reader, index, region);
+    });
+    m_statistics.add_read(result.total() * result.elemSize());
+    return result;
+}
+
+std::vector<cv::Mat> ome_tiff_io_impl::read_planes(const std::vector<misa_ome_plane_description> &indices) const {
+    std::vector<cv::Mat> result(indices.size());
+    read_planes(indices, result);
+    return result;
+}
+
+void ome_tiff_io_impl::read_planes(const std::vector<misa_ome_plane_description> &indices, std::vector<cv::Mat> &destinations) const {
+    if(destinations.size() != indices.size())
+        throw std::logic_error("Each plane requires a destination!");
+
+    // Provided destinations are not allowed to be reallocated
+    std::vector<const uchar*> provided;
+    for(const auto &dst : destinations) {
+        provided.push_back(dst.data);
+    }
+
+    // Fails if a series does not exist
+    for(const auto &index : indices) {
+        get_dimensions(index.series);
+    }
+
+    // Planes are read in the order they are stored within the OME TIFF
+    std::vector<size_t> order(indices.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [this, &indices](size_t lhs, size_t rhs) {
+        return std::make_pair(indices[lhs].series, get_plane_index(indices[lhs])) <
+               std::make_pair(indices[rhs].series, get_plane_index(indices[rhs]));
+    });
 
-//    std::cout << "[MISA++ OME] Soft locking " << m_path << " to read data" << "\n";
     std::shared_lock<std::shared_mutex> lock { m_mutex, std::defer_lock };
-    lock.lock();
-//    std::cout << "[MISA++ OME] Soft locking " << m_path << " to read data .. successful" << "\n";
+    lock_timed(lock);
+
+    // All planes are located before any is read. Opening the main reader releases the lock and might flush the
+    // write buffer, so the planes are located again in a single pass that holds the lock once the reader is available.
+    std::vector<bool> buffered(indices.size(), false);
+    bool located = false;
+    while(!located) {
+        located = true;
+        for(size_t i : order) {
+            if(!static_cast<bool>(m_reader) && !m_write_buffer->contains(indices[i])) {
+                prepare_read(indices[i], lock);
+                located = false;
+                break;
+            }
+            buffered[i] = prepare_read(indices[i], lock);
+        }
+    }
+
+    // Each worker decodes a contiguous range of planes with its own reader
+    const size_t num_workers = std::max<size_t>(1, std::min(get_num_threads(), order.size()));
+    const size_t chunk_size = (order.size() + num_workers - 1) / num_workers;
+    const auto read_range = [this, &indices, &order, &buffered, &destinations](size_t first, size_t last) {
+        std::unique_ptr<borrowed_reader> reader;
+        for(size_t j = first; j < last; ++j) {
+            const size_t i = order[j];
+            const auto &index = indices[i];
+            cv::Mat &dst = destinations[i];
+            if(buffered[i]) {
+                const auto timer = m_statistics.time(ome_tiff_io_timer::write_buffer_read);
+                m_write_buffer->read_into(index, dst);
+            }
+            else if(static_cast<bool>(m_mapping) && m_mapping->contains(index)) {
+                const cv::Mat plane = m_mapping->read_plane(index);
+                if(dst.empty())
+                    dst = plane;
+                else
+                    plane.copyTo(dst);
+            }
+            else {
+                if(!static_cast<bool>(reader) || reader->reader->getSeries() != index.series) {
+                    reader.reset();
+                    reader = std::make_unique<borrowed_reader>(*this, index.series);
+                }
+                decode_plane(*reader->reader, index, cv::Rect(0, 0, static_cast<int>(get_size_x(index.series)),
+                        static_cast<int>(get_size_y(index.series))), dst);
+            }
+            m_statistics.add_read(dst.total() * dst.elemSize());
+        }
+    };
 
-    if(m_write_buffer.find(index) == m_write_buffer.end()) {
+    const auto pool = get_workers();
+    std::vector<std::future<void>> workers;
+    for(size_t first = chunk_size; first < order.size(); first += chunk_size) {
+        const size_t last = std::min(first + chunk_size, order.size());
+        workers.emplace_back(pool->submit([&read_range, first, last]() {
+            read_range(first, last);
+        }));
+    }
 
-        lock.unlock();
-//        std::cout << "[MISA++ OME] Locking " << m_path << " to read data from OME TIFF" << "\n";
-        std::unique_lock<std::shared_mutex> wlock { m_mutex, std::defer_lock };
-        wlock.lock();
-//        std::cout << "[MISA++ OME] Locking " << m_path << " to read data from OME TIFF .. successful" << "\n";
+    // The first range is read by this thread. All workers must finish before an error is reported.
+    std::exception_ptr error;
+    try {
+        read_range(0, std::min(chunk_size, order.size()));
+    }
+    catch(...) {
+        error = std::current_exception();
+    }
+    for(auto &worker : workers) {
+        try {
+            worker.get();
+        }
+        catch(...) {
+            if(!error)
+                error = std::current_exception();
+        }
+    }
+    if(error)
+        std::rethrow_exception(error);
+
+    for(size_t i = 0; i < destinations.size(); ++i) {
+        if(provided[i] != nullptr && destinations[i].data != provided[i])
+            throw std::runtime_error("The plane " + misaxx::utils::to_string(indices[i]) + " does not have the size and type of its destination!");
+    }
+}
 
-        return ome_to_opencv(*get_reader(index), index);
-    } else {
-        // The write buffer contains only standard TIFFs
-        return misaxx::imaging::utils::tiffread(m_write_buffer.at(index));
+cv::Mat ome_tiff_io_impl::read_volume(::ome::files::dimension_size_type series, ::ome::files::dimension_size_type c,
+                                      ::ome::files::dimension_size_type t) const {
+    const auto &dimensions = get_dimensions(series);
+    if(c >= dimensions.size_C || t >= dimensions.size_T)
+        throw std::runtime_error("The OME TIFF " + m_path.string() + " does not contain the channel " + std::to_string(c) + " at time " + std::to_string(t) + "!");
+    const int sizes[] = { static_cast<int>(dimensions.size_Z), static_cast<int>(dimensions.size_Y), static_cast<int>(dimensions.size_X) };
+    cv::Mat volume(3, sizes, get_opencv_type(series, c));
+
+    // Each plane is decoded into its slice of the volume
+    std::vector<misa_ome_plane_description> indices;
+    std::vector<cv::Mat> slices;
+    for(::ome::files::dimension_size_type z = 0; z < dimensions.size_Z; ++z) {
+        indices.emplace_back(series, z, c, t);
+        slices.emplace_back(sizes[1], sizes[2], volume.type(), volume.ptr(static_cast<int>(z)));
+    }
+    read_planes(indices, slices);
+    return volume;
+}
+
+void ome_tiff_io_impl::write_volume(const cv::Mat &volume, ::ome::files::dimension_size_type series,
+                                    ::ome::files::dimension_size_type c, ::ome::files::dimension_size_type t) {
+    const auto &dimensions = get_dimensions(series);
+    if(c >= dimensions.size_C || t >= dimensions.size_T)
+        throw std::runtime_error("The OME TIFF " + m_path.string() + " does not contain the channel " + std::to_string(c) + " at time " + std::to_string(t) + "!");
+    if(volume.dims != 3 || volume.size[0] != static_cast<int>(dimensions.size_Z) || volume.size[1] != static_cast<int>(dimensions.size_Y) ||
+       volume.size[2] != static_cast<int>(dimensions.size_X))
+        throw std::runtime_error("The volume does not have the size Z x Y x X of " + m_path.string() + "!");
+
+    // The slices are encoded without copying them
+    for(int z = 0; z < volume.size[0]; ++z) {
+        const cv::Mat slice(volume.size[1], volume.size[2], volume.type(), const_cast<uchar*>(volume.ptr(z)), volume.step[1]);
+        write_plane(slice, misa_ome_plane_description(series, static_cast<::ome::files::dimension_size_type>(z), c, t));
     }
 }
 
 void ome_tiff_io_impl::write_plane(const cv::Mat &image, const misa_ome_plane_description &index) {
+    // Fails if the series does not exist
+    get_dimensions(index.series);
+
+    // Planes that go into the write buffer are encoded while only holding a shared lock, so multiple planes can be compressed in parallel.
+    // They are stored after the state of this IO was checked under the exclusive lock.
+    std::unique_ptr<ome_write_buffer::encoded_plane> encoded;
+    if(!direct_writing_is_enabled()) {
+        std::shared_lock<std::shared_mutex> lock { m_mutex, std::defer_lock };
+        lock_timed(lock);
+        const auto timer = m_statistics.time(ome_tiff_io_timer::write_buffer_write);
+        encoded = m_write_buffer->encode(index, image, get_compression());
+    }
+
     // Lock this IO to allow writing to the write buffer
 //    std::cout << "[MISA++ OME] Locking " << m_path << " to write data" << "\n";
     std::unique_lock<std::shared_mutex> lock { m_mutex, std::defer_lock };
-    lock.lock();
+    lock_timed(lock);
+    m_statistics.add_written(image.total() * image.elemSize());
+
+    // A prefetched copy of this plane would be outdated
+    cancel_prefetched(index);
 //    std::cout << "[MISA++ OME] Locking " << m_path << " to write data ... successful" << "\n";
 
-    if(index.series != 0)
-        throw std::runtime_error("Only series 0 is currently supported!");
+    if(is_written_to_writer(index)) {
+        throw std::runtime_error("Plane " + misaxx::utils::to_string(index) + " was already written into " + m_path.string() + "!");
+    }
 
-    // If the file already exists, we have to create a write buffer
-    if(m_write_buffer.empty() && boost::filesystem::exists(m_path)) {
+    // If the file already exists, only the modified planes are buffered
+    // The other planes can still be read from the existing file
+    if(m_write_buffer->empty() && !static_cast<bool>(m_writer) && boost::filesystem::exists(m_path)) {
         std::cout << "[MISA++ OME] Preparing write mode for existing OME TIFF " << m_path << " ... " << "\n";
-        for(size_t series = 0; series < get_num_series(); ++series) {
-            m_reader->setSeries(series);
-            const auto size_Z = m_reader->getSizeZ();
-            const auto size_C = m_reader->getEffectiveSizeC();
-            const auto size_T = m_reader->getSizeT();
-
-            for(size_t z = 0; z < size_Z; ++z) {
-                for(size_t c = 0; c < size_C; ++c) {
-                    for (size_t t = 0; t < size_T; ++t) {
-                        const misa_ome_plane_description location(series, z, c, t);
-                        const auto location_name = misaxx::utils::to_string(location);
-                        std::cout << "[MISA++ OME] Preparing write mode for existing OME TIFF " << m_path << " ... writing plane " << location_name << "\n";
-
-                        const boost::filesystem::path buffer_path = get_write_buffer_path(location);
-                        if(!boost::filesystem::is_directory(buffer_path.parent_path())) {
-                            boost::filesystem::create_directories(buffer_path.parent_path());
-                        }
-
-                        cv::Mat tmp = ome_to_opencv(*m_reader, misa_ome_plane_description(series, z, c, t));
-                        misaxx::imaging::utils::tiffwrite(tmp, buffer_path);
-                    }
-                }
-            }
+        if(!static_cast<bool>(m_metadata)) {
+            get_reader(index);
+        }
+        m_write_buffer_updates_existing = true;
+    }
+
+    // New files can be streamed directly into the OME TIFF if the planes arrive in order
+    if(direct_writing_is_enabled() && !static_cast<bool>(m_writer) && m_write_buffer->empty() && !boost::filesystem::exists(m_path)) {
+        std::cout << "[MISA++ OME] Directly writing into new OME TIFF " << m_path << "\n";
+        m_writer = create_writer();
+    }
+    if(static_cast<bool>(m_writer) && m_writer_series == index.series && get_plane_index(index) == m_writer_plane) {
+        write_plane_to_writer(image, index);
+        flush_write_buffer_to_writer();
+        return;
+    }
+
+    {
+        const auto timer = m_statistics.time(ome_tiff_io_timer::write_buffer_write);
+        // The write buffer format might have been changed since the plane was encoded
+        if(static_cast<bool>(encoded) && encoded->format == m_write_buffer->get_format()) {
+            m_write_buffer->add(std::move(encoded));
+        }
+        else {
+            m_write_buffer->write(index, image, get_compression());
         }
     }
 
-    const boost::filesystem::path buffer_path = get_write_buffer_path(index);
-    if(!boost::filesystem::is_directory(buffer_path.parent_path())) {
-        boost::filesystem::create_directories(buffer_path.parent_path());
+    // The writer might have been waiting for this plane
+    if(static_cast<bool>(m_writer)) {
+        flush_write_buffer_to_writer();
     }
-    misaxx::imaging::utils::tiff_compression compression;
-    if(compression_is_enabled())
-        compression = misaxx::imaging::utils::tiff_compression::lzw;
-    else
-        compression = misaxx::imaging::utils::tiff_compression::none;
-    misaxx::imaging::utils::tiffwrite(image, buffer_path, compression);
-    m_write_buffer[index] = buffer_path;
 }
 
 ::ome::files::dimension_size_type ome_tiff_io_impl::get_num_series() const {
-    return get_metadata()->getImageCount();
+    require_dimensions();
+    return m_dimensions.size();
 }
 
 ::ome::files::dimension_size_type ome_tiff_io_impl::get_size_x(::ome::files::dimension_size_type series) const {
-    return get_metadata()->getPixelsSizeX(series);
+    return get_dimensions(series).size_X;
 }
 
 ::ome::files::dimension_size_type ome_tiff_io_impl::get_size_y(::ome::files::dimension_size_type series) const {
-    return get_metadata()->getPixelsSizeY(series);
+    return get_dimensions(series).size_Y;
 }
 
 ::ome::files::dimension_size_type ome_tiff_io_impl::get_size_z(::ome::files::dimension_size_type series) const {
-    return get_metadata()->getPixelsSizeZ(series);
+    return get_dimensions(series).size_Z;
 }
 
 ::ome::files::dimension_size_type ome_tiff_io_impl::get_size_t(::ome::files::dimension_size_type series) const {
-    return get_metadata()->getPixelsSizeT(series);
+    return get_dimensions(series).size_T;
 }
 
 ::ome::files::dimension_size_type ome_tiff_io_impl::get_size_c(::ome::files::dimension_size_type series) const {
-    return get_metadata()->getChannelCount(series);
+    return get_dimensions(series).size_C;
 }
 
 ::ome::files::dimension_size_type
 ome_tiff_io_impl::get_num_planes(::ome::files::dimension_size_type series) const {
-    return get_size_c(series) * get_size_t(series) * get_size_z(series);
+    const auto &dimensions = get_dimensions(series);
+    return dimensions.size_C * dimensions.size_T * dimensions.size_Z;
 }
 
 boost::filesystem::path ome_tiff_io_impl::get_path() const {
@@ -414,11 +1392,327 @@ boost::filesystem::path ome_tiff_io_impl::get_path() const {
 }
 
 bool ome_tiff_io_impl::compression_is_enabled() const {
-    return m_enable_compression;
+    return m_compression.is_enabled();
 }
 
 void ome_tiff_io_impl::set_compression(bool enabled) {
-    m_enable_compression = enabled;
+    m_compression = enabled ? ome_tiff_compression(ome_tiff_codec::lzw) : ome_tiff_compression();
+}
+
+const ome_tiff_compression &ome_tiff_io_impl::get_compression() const {
+    return m_compression;
+}
+
+void ome_tiff_io_impl::set_compression(ome_tiff_compression compression) {
+    if(compression.is_enabled() && !compression.is_supported())
+        throw std::runtime_error("The TIFF compression codec is not supported by libtiff!");
+    m_compression = compression;
+}
+
+bool ome_tiff_io_impl::direct_writing_is_enabled() const {
+    return m_enable_direct_writing;
+}
+
+void ome_tiff_io_impl::set_direct_writing(bool enabled) {
+    m_enable_direct_writing = enabled;
+}
+
+::ome::files::dimension_size_type ome_tiff_io_impl::get_tile_size() const {
+    return m_tile_size;
+}
+
+size_t ome_tiff_io_impl::get_num_threads() const {
+    return m_num_threads;
+}
+
+void ome_tiff_io_impl::set_num_threads(size_t num_threads) {
+    std::lock_guard<std::mutex> lock(m_workers_mutex);
+    m_num_threads = num_threads > 0 ? num_threads : get_default_num_threads();
+    // Running tasks keep the previous pool alive
+    m_workers.reset();
+}
+
+std::shared_ptr<ome_worker_pool> ome_tiff_io_impl::get_workers() const {
+    std::lock_guard<std::mutex> lock(m_workers_mutex);
+    if(!static_cast<bool>(m_workers)) {
+        m_workers = std::make_shared<ome_worker_pool>(m_num_threads - 1);
+    }
+    return m_workers;
+}
+
+size_t ome_tiff_io_impl::get_default_num_threads() {
+    // Multiple OME TIFFs are usually accessed at the same time
+    return std::max<size_t>(1, std::min<size_t>(4, std::thread::hardware_concurrency()));
+}
+
+size_t ome_tiff_io_impl::get_prefetch_depth() const {
+    return m_prefetch_depth;
+}
+
+bool ome_tiff_io_impl::memory_mapping_is_enabled() const {
+    return m_enable_memory_mapping;
+}
+
+void ome_tiff_io_impl::set_memory_mapping(bool enabled) {
+    m_enable_memory_mapping = enabled;
+}
+
+ome_write_buffer_format ome_tiff_io_impl::get_write_buffer_format() const {
+    return m_write_buffer_format;
+}
+
+void ome_tiff_io_impl::set_write_buffer_format(ome_write_buffer_format format) {
+    std::unique_lock<std::shared_mutex> lock(m_mutex);
+    if(format == m_write_buffer_format)
+        return;
+    if(!m_write_buffer->empty())
+        throw std::logic_error("The write buffer format cannot be changed while the write buffer contains planes!");
+    m_write_buffer = ome_write_buffer::create(format, m_path, m_write_buffer_dataset);
+    m_write_buffer_format = format;
+}
+
+size_t ome_tiff_io_impl::get_pyramid_levels() const {
+    return m_pyramid_levels;
+}
+
+void ome_tiff_io_impl::set_pyramid_levels(size_t levels) {
+    m_pyramid_levels = levels;
+}
+
+int ome_tiff_io_impl::get_opencv_type(::ome::files::dimension_size_type series, ::ome::files::dimension_size_type c) const {
+    const auto &dimensions = get_dimensions(series);
+    const int depth = ome_pixel_type_to_opencv_depth(dimensions.pixel_type);
+    if(depth < 0)
+        throw std::runtime_error("OpenCV does not support the pixel type of " + m_path.string() + "!");
+    if(c >= dimensions.samples_per_pixel.size())
+        throw std::runtime_error("The OME TIFF " + m_path.string() + " does not contain channel " + std::to_string(c) + "!");
+    return CV_MAKETYPE(depth, static_cast<int>(dimensions.samples_per_pixel[c]));
+}
+
+ome_tiff_io_statistics ome_tiff_io_impl::get_statistics() const {
+    return m_statistics.get();
+}
+
+void ome_tiff_io_impl::reset_statistics() {
+    m_statistics.reset();
+}
+
+size_t ome_tiff_io_impl::get_buffer_pool_capacity() const {
+    return ome_pixel_buffer_pool::global().get_capacity();
+}
+
+void ome_tiff_io_impl::set_buffer_pool_capacity(size_t capacity) {
+    ome_pixel_buffer_pool::global().set_capacity(capacity);
+}
+
+size_t ome_tiff_io_impl::restore_write_buffer() {
+    std::unique_lock<std::shared_mutex> lock(m_mutex);
+    if(boost::filesystem::exists(m_path) || !m_has_dimensions || !m_write_buffer->empty())
+        return 0;
+    const auto matches_dimensions = [this](const misa_ome_plane_description &location, int rows, int cols, int opencv_type) {
+        if(location.series >= m_dimensions.size())
+            return false;
+        const auto &dimensions = m_dimensions[location.series];
+        if(location.z >= dimensions.size_Z || location.c >= dimensions.size_C || location.t >= dimensions.size_T)
+            return false;
+        if(rows < 0 || cols < 0 || static_cast<::ome::files::dimension_size_type>(rows) != dimensions.size_Y ||
+           static_cast<::ome::files::dimension_size_type>(cols) != dimensions.size_X)
+            return false;
+        const int depth = ome_pixel_type_to_opencv_depth(dimensions.pixel_type);
+        return depth >= 0 && opencv_type == CV_MAKETYPE(depth, static_cast<int>(dimensions.samples_per_pixel[location.c]));
+    };
+    const size_t num_restored = m_write_buffer->restore(matches_dimensions);
+    if(num_restored > 0) {
+        std::cout << "[MISA++ OME] Restored " << num_restored << " planes of an interrupted run from the write buffer of " << m_path << "\n";
+    }
+    return num_restored;
+}
+
+cv::Mat ome_tiff_io_impl::read_plane_level(const misa_ome_plane_description &index, size_t level) const {
+    if(level == 0)
+        return read_plane(index);
+
+    const auto from_pyramid = [this, &index, level]() {
+        const auto pyramid = get_pyramid();
+        return static_cast<bool>(pyramid) ? pyramid->read_level(index, level) : cv::Mat();
+    };
+    cv::Mat result = read_plane_with(index, [](const ome_write_buffer &) {
+        return cv::Mat();
+    }, [&from_pyramid](const ome_tiff_mapping &) {
+        return from_pyramid();
+    }, [&from_pyramid](const custom_ome_tiff_reader &) {
+        return from_pyramid();
+    });
+    if(!result.empty())
+        return result;
+
+    // Levels that are not stored in the file are computed from the plane
+    result = read_plane(index);
+    for(size_t i = 0; i < level; ++i) {
+        result = ome_tiff_downsample(result);
+    }
+    return result;
+}
+
+bool ome_tiff_io_impl::is_buffered(const misa_ome_plane_description &index) const {
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+    return m_write_buffer->contains(index);
+}
+
+void ome_tiff_io_impl::set_prefetch_depth(size_t depth) {
+    m_prefetch_depth = depth;
+    if(depth == 0) {
+        discard_prefetched(false);
+    }
+}
+
+void ome_tiff_io_impl::prefetch_after(const misa_ome_plane_description &t_location, size_t plane_bytes) const {
+    std::vector<misa_ome_plane_description> window;
+    misa_ome_plane_description next = t_location;
+    while(window.size() < get_prefetch_depth() && get_next_plane(next)) {
+        window.push_back(next);
+    }
+
+    std::lock_guard<std::mutex> prefetch_lock(m_prefetch_mutex);
+
+    // Planes outside of the read-ahead window were skipped. Their decoding is not waited for.
+    for(auto it = m_prefetched.begin(); it != m_prefetched.end();) {
+        if(std::find(window.begin(), window.end(), it->first) == window.end()) {
+            it->second->cancelled = true;
+            it = m_prefetched.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+
+    bool queued = false;
+    for(const auto &location : window) {
+        if(m_prefetched.find(location) != m_prefetched.end())
+            continue;
+        // Prefetched planes must fit into the prefetch limit and the plane cache memory limit
+        const size_t prefetched_bytes = plane_bytes * (m_prefetched.size() + 1);
+        if(prefetched_bytes > get_prefetch_limit() || !ome_plane_lru::global().has_space(prefetched_bytes))
+            break;
+        auto task = std::make_shared<prefetch_task>();
+        task->location = location;
+        task->result = task->promise.get_future().share();
+        m_prefetched[location] = task;
+        m_prefetch_queue.push_back(task);
+        queued = true;
+    }
+
+    if(queued) {
+        if(!m_prefetch_thread.joinable()) {
+            m_prefetch_thread = std::thread([this]() {
+                prefetch_worker();
+            });
+        }
+        m_prefetch_changed.notify_all();
+    }
+}
+
+void ome_tiff_io_impl::prefetch_worker() const {
+    std::unique_lock<std::mutex> prefetch_lock(m_prefetch_mutex);
+    while(true) {
+        m_prefetch_changed.wait(prefetch_lock, [this]() {
+            return m_prefetch_stopping || !m_prefetch_queue.empty();
+        });
+        if(m_prefetch_stopping)
+            return;
+        const auto task = m_prefetch_queue.front();
+        m_prefetch_queue.pop_front();
+        if(task->cancelled)
+            continue;
+
+        m_prefetch_busy = true;
+        prefetch_lock.unlock();
+        try {
+            task->promise.set_value(read_plane_uncached(task->location));
+        }
+        catch(...) {
+            task->promise.set_exception(std::current_exception());
+        }
+        prefetch_lock.lock();
+        m_prefetch_busy = false;
+        m_prefetch_changed.notify_all();
+    }
+}
+
+std::shared_future<cv::Mat> ome_tiff_io_impl::take_prefetched(const misa_ome_plane_description &t_location) const {
+    std::lock_guard<std::mutex> prefetch_lock(m_prefetch_mutex);
+    const auto it = m_prefetched.find(t_location);
+    if(it == m_prefetched.end())
+        return std::shared_future<cv::Mat>();
+    std::shared_future<cv::Mat> result = it->second->result;
+    m_prefetched.erase(it);
+    return result;
+}
+
+void ome_tiff_io_impl::cancel_prefetched(const misa_ome_plane_description &t_location) const {
+    std::lock_guard<std::mutex> prefetch_lock(m_prefetch_mutex);
+    const auto it = m_prefetched.find(t_location);
+    if(it != m_prefetched.end()) {
+        it->second->cancelled = true;
+        m_prefetched.erase(it);
+    }
+}
+
+void ome_tiff_io_impl::discard_prefetched(bool wait) const {
+    std::unique_lock<std::mutex> prefetch_lock(m_prefetch_mutex);
+    for(const auto &kv : m_prefetched) {
+        kv.second->cancelled = true;
+    }
+    m_prefetched.clear();
+    m_prefetch_queue.clear();
+    if(wait) {
+        m_prefetch_changed.wait(prefetch_lock, [this]() {
+            return !m_prefetch_busy;
+        });
+    }
+}
+
+void ome_tiff_io_impl::stop_prefetching() const {
+    discard_prefetched(false);
+    {
+        std::lock_guard<std::mutex> prefetch_lock(m_prefetch_mutex);
+        m_prefetch_stopping = true;
+    }
+    m_prefetch_changed.notify_all();
+    if(m_prefetch_thread.joinable()) {
+        m_prefetch_thread.join();
+    }
+}
+
+size_t ome_tiff_io_impl::get_prefetch_limit() const {
+    return m_prefetch_limit;
+}
+
+void ome_tiff_io_impl::set_prefetch_limit(size_t limit) {
+    m_prefetch_limit = limit;
+    if(limit == 0) {
+        discard_prefetched(false);
+    }
+}
+
+bool ome_tiff_io_impl::get_next_plane(misa_ome_plane_description &t_location) const {
+    // Same order as the plane caches of misa_ome_tiff_cache
+    if(++t_location.t < get_size_t(t_location.series))
+        return true;
+    t_location.t = 0;
+    if(++t_location.c < get_size_c(t_location.series))
+        return true;
+    t_location.c = 0;
+    if(++t_location.z < get_size_z(t_location.series))
+        return true;
+    t_location.z = 0;
+    return ++t_location.series < get_num_series();
+}
+
+void ome_tiff_io_impl::set_tile_size(::ome::files::dimension_size_type tile_size) {
+    if(tile_size % 16 != 0)
+        throw std::runtime_error("The TIFF tile size must be a multiple of 16!");
+    m_tile_size = tile_size;
 }
 
 ome_tiff_io::ome_tiff_io() : m_pimpl(new ome_tiff_io_impl()){
@@ -430,13 +1724,15 @@ ome_tiff_io::ome_tiff_io(boost::filesystem::path t_path) : m_pimpl(new ome_tiff_
 }
 
 ome_tiff_io::ome_tiff_io(boost::filesystem::path t_path,
-                         std::shared_ptr<::ome::xml::meta::OMEXMLMetadata> t_metadata) :
-        m_pimpl(new ome_tiff_io_impl(std::move(t_path), std::move(t_metadata))){
+                         std::shared_ptr<::ome::xml::meta::OMEXMLMetadata> t_metadata,
+                         ome_write_buffer_format t_write_buffer_format) :
+        m_pimpl(new ome_tiff_io_impl(std::move(t_path), std::move(t_metadata), t_write_buffer_format)){
 
 }
 
-ome_tiff_io::ome_tiff_io(boost::filesystem::path t_path, const ome_tiff_io &t_reference) :
-        m_pimpl(new ome_tiff_io_impl(std::move(t_path), t_reference)){
+ome_tiff_io::ome_tiff_io(boost::filesystem::path t_path, const ome_tiff_io &t_reference,
+                         ome_write_buffer_format t_write_buffer_format) :
+        m_pimpl(new ome_tiff_io_impl(std::move(t_path), t_reference, t_write_buffer_format)){
 
 }
 
@@ -452,6 +1748,28 @@ cv::Mat ome_tiff_io::read_plane(const misa_ome_plane_description &index) const {
     return m_pimpl->read_plane(index);
 }
 
+void ome_tiff_io::read_plane(const misa_ome_plane_description &index, cv::Mat &dst) const {
+    m_pimpl->read_plane(index, dst);
+}
+
+cv::Mat ome_tiff_io::read_plane_region(const misa_ome_plane_description &index, const cv::Rect &region) const {
+    return m_pimpl->read_plane_region(index, region);
+}
+
+std::vector<cv::Mat> ome_tiff_io::read_planes(const std::vector<misa_ome_plane_description> &indices) const {
+    return m_pimpl->read_planes(indices);
+}
+
+cv::Mat ome_tiff_io::read_volume(::ome::files::dimension_size_type series, ::ome::files::dimension_size_type c,
+                                 ::ome::files::dimension_size_type t) const {
+    return m_pimpl->read_volume(series, c, t);
+}
+
+void ome_tiff_io::write_volume(const cv::Mat &volume, ::ome::files::dimension_size_type series,
+                               ::ome::files::dimension_size_type c, ::ome::files::dimension_size_type t) {
+    m_pimpl->write_volume(volume, series, c, t);
+}
+
 std::shared_ptr<::ome::xml::meta::OMEXMLMetadata> ome_tiff_io::get_metadata() const {
     return m_pimpl->get_metadata();
 }
@@ -464,6 +1782,10 @@ void ome_tiff_io::close(bool remove_write_buffer) {
     m_pimpl->close(remove_write_buffer);
 }
 
+const ome_tiff_series_dimensions &ome_tiff_io::get_dimensions(::ome::files::dimension_size_type series) const {
+    return m_pimpl->get_dimensions(series);
+}
+
 ::ome::files::dimension_size_type ome_tiff_io::get_num_series() const {
     return m_pimpl->get_num_series();
 }
@@ -498,4 +1820,104 @@ bool ome_tiff_io::compression_is_enabled() const {
 
 void ome_tiff_io::set_compression(bool enabled) {
     m_pimpl->set_compression(enabled);
-}
\ No newline at end of file
+}
+
+const ome_tiff_compression &ome_tiff_io::get_compression() const {
+    return m_pimpl->get_compression();
+}
+
+void ome_tiff_io::set_compression(ome_tiff_compression compression) {
+    m_pimpl->set_compression(compression);
+}
+
+bool ome_tiff_io::direct_writing_is_enabled() const {
+    return m_pimpl->direct_writing_is_enabled();
+}
+
+void ome_tiff_io::set_direct_writing(bool enabled) {
+    m_pimpl->set_direct_writing(enabled);
+}
+
+::ome::files::dimension_size_type ome_tiff_io::get_tile_size() const {
+    return m_pimpl->get_tile_size();
+}
+
+void ome_tiff_io::set_tile_size(::ome::files::dimension_size_type tile_size) {
+    m_pimpl->set_tile_size(tile_size);
+}
+
+size_t ome_tiff_io::get_num_threads() const {
+    return m_pimpl->get_num_threads();
+}
+
+void ome_tiff_io::set_num_threads(size_t num_threads) {
+    m_pimpl->set_num_threads(num_threads);
+}
+
+size_t ome_tiff_io::get_prefetch_depth() const {
+    return m_pimpl->get_prefetch_depth();
+}
+
+void ome_tiff_io::set_prefetch_depth(size_t depth) {
+    m_pimpl->set_prefetch_depth(depth);
+}
+
+size_t ome_tiff_io::get_prefetch_limit() const {
+    return m_pimpl->get_prefetch_limit();
+}
+
+void ome_tiff_io::set_prefetch_limit(size_t limit) {
+    m_pimpl->set_prefetch_limit(limit);
+}
+
+bool ome_tiff_io::memory_mapping_is_enabled() const {
+    return m_pimpl->memory_mapping_is_enabled();
+}
+
+void ome_tiff_io::set_memory_mapping(bool enabled) {
+    m_pimpl->set_memory_mapping(enabled);
+}
+
+ome_write_buffer_format ome_tiff_io::get_write_buffer_format() const {
+    return m_pimpl->get_write_buffer_format();
+}
+
+void ome_tiff_io::set_write_buffer_format(ome_write_buffer_format format) {
+    m_pimpl->set_write_buffer_format(format);
+}
+
+size_t ome_tiff_io::restore_write_buffer() {
+    return m_pimpl->restore_write_buffer();
+}
+
+bool ome_tiff_io::is_buffered(const misa_ome_plane_description &index) const {
+    return m_pimpl->is_buffered(index);
+}
+
+cv::Mat ome_tiff_io::read_plane_level(const misa_ome_plane_description &index, size_t level) const {
+    return m_pimpl->read_plane_level(index, level);
+}
+
+size_t ome_tiff_io::get_pyramid_levels() const {
+    return m_pimpl->get_pyramid_levels();
+}
+
+void ome_tiff_io::set_pyramid_levels(size_t levels) {
+    m_pimpl->set_pyramid_levels(levels);
+}
+
+ome_tiff_io_statistics ome_tiff_io::get_statistics() const {
+    return m_pimpl->get_statistics();
+}
+
+void ome_tiff_io::reset_statistics() {
+    m_pimpl->reset_statistics();
+}
+
+size_t ome_tiff_io::get_buffer_pool_capacity() const {
+    return m_pimpl->get_buffer_pool_capacity();
+}
+
+void ome_tiff_io::set_buffer_pool_capacity(size_t capacity) {
+    m_pimpl->set_buffer_pool_capacity(capacity);
+}
@@ -15,12 +15,18 @@
 #include <memory>
 #include <shared_mutex>
 #include <unordered_set>
+#include <vector>
 #include <opencv2/opencv.hpp>
 #include <boost/filesystem.hpp>
 #include <misaxx/core/misa_cache.h>
 #include <boost/regex.hpp>
 #include <ome/xml/meta/OMEXMLMetadata.h>
 #include <ome/files/Types.h>
+#include <ome/xml/model/enums/PixelType.h>
+#include <ome/xml/model/enums/DimensionOrder.h>
+#include "ome_tiff_compression.h"
+#include "ome_write_buffer.h"
+#include "ome_tiff_io_statistics.h"
 
 namespace misaxx::ome {
 
@@ -29,11 +35,32 @@ namespace misaxx::ome {
 
     struct ome_tiff_io_impl;
 
+    /**
+     * Dimensions and pixel type of an image series.
+     * Taken from the OME XML metadata when it is loaded, so they can be queried without accessing the metadata.
+     */
+    struct ome_tiff_series_dimensions {
+        ::ome::files::dimension_size_type size_X = 0;
+        ::ome::files::dimension_size_type size_Y = 0;
+        ::ome::files::dimension_size_type size_Z = 0;
+        ::ome::files::dimension_size_type size_C = 0;
+        ::ome::files::dimension_size_type size_T = 0;
+        ::ome::xml::model::enums::PixelType pixel_type = ::ome::xml::model::enums::PixelType::UINT8;
+        ::ome::xml::model::enums::DimensionOrder dimension_order = ::ome::xml::model::enums::DimensionOrder::XYZCT;
+        /**
+         * Number of samples per pixel of each channel
+         */
+        std::vector<::ome::files::dimension_size_type> samples_per_pixel;
+    };
+
     /**
      * Allows thread-safe read and write access to an OME TIFF
      * This wrapper will automatically switch between an OME TIFF reader and an OME TIFF writer depending on what functionality
      * is currently being requested.
      *
+     * Planes can be read concurrently from multiple threads, as each reading thread borrows its own OME TIFF reader.
+     * Readers are kept per series, so planes of different series can be read concurrently without relocating a reader.
+     *
      * Please note that this IO, similar to ome::files TIFF reader & writer needs to be closed manually
      */
     class ome_tiff_io {
@@ -52,16 +79,20 @@ namespace misaxx::ome {
          *  If the file already exists, the metadata is loaded from the file instead.
          * @param t_path
          * @param t_metadata
+         * @param t_write_buffer_format how written planes are stored until they are assembled into the OME TIFF
          */
         explicit ome_tiff_io(boost::filesystem::path t_path,
-                                     std::shared_ptr<::ome::xml::meta::OMEXMLMetadata> t_metadata);
+                                     std::shared_ptr<::ome::xml::meta::OMEXMLMetadata> t_metadata,
+                                     ome_write_buffer_format t_write_buffer_format = ome_write_buffer_format::files);
 
         /**
          * Opens an existing OME TIFF file or creates a new one based on the reference
          * @param t_path
          * @param t_reference
+         * @param t_write_buffer_format how written planes are stored until they are assembled into the OME TIFF
          */
-        explicit ome_tiff_io(boost::filesystem::path t_path, const ome_tiff_io &t_reference);
+        explicit ome_tiff_io(boost::filesystem::path t_path, const ome_tiff_io &t_reference,
+                             ome_write_buffer_format t_write_buffer_format = ome_write_buffer_format::files);
 
         ~ome_tiff_io();
 
@@ -69,6 +100,69 @@ namespace misaxx::ome {
 
         cv::Mat read_plane(const misa_ome_plane_description &index) const;
 
+        /**
+         * Reads a plane into an existing cv::Mat without allocating a new one.
+         * The destination can be a region of interest of a larger cv::Mat.
+         * @param index the plane
+         * @param dst Must have the size and type of the plane. If empty, it is allocated.
+         */
+        void read_plane(const misa_ome_plane_description &index, cv::Mat &dst) const;
+
+        /**
+         * Reads a rectangular region of a plane.
+         * Only the strips or tiles that overlap with the region are decoded.
+         * @param index the plane
+         * @param region the region within the plane
+         * @return
+         */
+        cv::Mat read_plane_region(const misa_ome_plane_description &index, const cv::Rect &region) const;
+
+        /**
+         * Reads multiple planes at once. The planes are read in the order they are stored within the OME TIFF
+         * and decoded in parallel (see get_num_threads()). The lock and readers are only acquired once.
+         * @param indices the planes
+         * @return The planes in the order of the indices
+         */
+        std::vector<cv::Mat> read_planes(const std::vector<misa_ome_plane_description> &indices) const;
+
+        /**
+         * Reads all planes of the depth axis into one contiguous volume.
+         * Each plane is decoded directly into its slice of the volume.
+         * @param series
+         * @param c location within the channel axis
+         * @param t location within the time axis
+         * @return A three-dimensional cv::Mat with the sizes Z, Y and X
+         */
+        cv::Mat read_volume(::ome::files::dimension_size_type series, ::ome::files::dimension_size_type c, ::ome::files::dimension_size_type t) const;
+
+        /**
+         * Writes all planes of the depth axis from one contiguous volume.
+         * The slices of the volume are written without copying them.
+         * @param volume A three-dimensional cv::Mat with the sizes Z, Y and X
+         * @param series
+         * @param c location within the channel axis
+         * @param t location within the time axis
+         */
+        void write_volume(const cv::Mat &volume, ::ome::files::dimension_size_type series, ::ome::files::dimension_size_type c, ::ome::files::dimension_size_type t);
+
+        /**
+         * Reads a reduced resolution level of a plane. Each level halves the width and height of the previous level.
+         * Levels that are stored in the OME TIFF are read without decoding the full plane.
+         * Other levels are computed from the plane.
+         * @param index the plane
+         * @param level the level. Level 0 is the plane itself.
+         * @return
+         */
+        cv::Mat read_plane_level(const misa_ome_plane_description &index, size_t level) const;
+
+        /**
+         * Returns true if the plane was written and is waiting in the write buffer.
+         * This includes planes that were restored from the write buffer of an interrupted run.
+         * @param index the plane
+         * @return
+         */
+        bool is_buffered(const misa_ome_plane_description &index) const;
+
         /**
          * Thread-safe access to the metadata
          * @return
@@ -82,6 +176,13 @@ namespace misaxx::ome {
          */
         void close(bool remove_write_buffer = true);
 
+        /**
+         * Dimensions and pixel type of a series. Does not access the metadata once it was loaded.
+         * @param series
+         * @return
+         */
+        const ome_tiff_series_dimensions &get_dimensions(::ome::files::dimension_size_type series) const;
+
         /**
          * The number of image series
          * @return
@@ -132,8 +233,150 @@ namespace misaxx::ome {
 
         bool compression_is_enabled() const;
 
+        /**
+         * Enables or disables LZW compression of written planes
+         * @param enabled
+         */
         void set_compression(bool enabled);
 
+        /**
+         * Compression settings of written planes
+         * @return
+         */
+        const ome_tiff_compression &get_compression() const;
+
+        /**
+         * Sets the compression of written planes.
+         * Codec, level and predictor are applied to the write buffer and the OME TIFF.
+         * Planes of existing OME TIFFs that are updated in place keep the codec of the file.
+         * @param compression
+         */
+        void set_compression(ome_tiff_compression compression);
+
+        bool direct_writing_is_enabled() const;
+
+        /**
+         * If enabled, planes of a new OME TIFF are streamed directly into the file if they are written in the order
+         * they are stored in. Other planes are buffered until the missing planes are available.
+         * While planes are streamed, only buffered planes can be read. Other planes cannot be read until the OME TIFF is closed.
+         * @param enabled
+         */
+        void set_direct_writing(bool enabled);
+
+        /**
+         * Width and height of the tiles in written OME TIFFs. If zero, the OME TIFF is stored in strips.
+         * @return
+         */
+        ::ome::files::dimension_size_type get_tile_size() const;
+
+        /**
+         * Sets the width and height of the tiles in written OME TIFFs. Set to zero to store the OME TIFF in strips.
+         * @param tile_size Must be a multiple of 16
+         */
+        void set_tile_size(::ome::files::dimension_size_type tile_size);
+
+        /**
+         * Number of threads that are used for decoding and encoding planes in parallel.
+         * The calling thread counts as one of them, the others belong to a worker pool of this IO.
+         * @return
+         */
+        size_t get_num_threads() const;
+
+        /**
+         * Sets the number of threads that are used for decoding and encoding planes in parallel
+         * @param num_threads If zero, up to 4 threads are used
+         */
+        void set_num_threads(size_t num_threads);
+
+        /**
+         * Number of planes that are decoded in the background after a plane was read
+         * @return
+         */
+        size_t get_prefetch_depth() const;
+
+        /**
+         * Sets the number of planes that are decoded in the background after a plane was read.
+         * Planes are prefetched in the order of misa_ome_tiff_cache (series, Z, C, T) by one background thread
+         * as long as they fit into the prefetch limit and the plane cache memory limit.
+         * @param depth If zero, no planes are prefetched
+         */
+        void set_prefetch_depth(size_t depth);
+
+        /**
+         * Maximum memory in bytes that is used by prefetched planes of this OME TIFF
+         * @return
+         */
+        size_t get_prefetch_limit() const;
+
+        /**
+         * Sets the maximum memory in bytes that is used by prefetched planes of this OME TIFF
+         * @param limit If zero, no planes are prefetched
+         */
+        void set_prefetch_limit(size_t limit);
+
+        bool memory_mapping_is_enabled() const;
+
+        /**
+         * If enabled, planes that are stored uncompressed are copied from a memory mapping of the OME TIFF instead of
+         * being decoded by the OME TIFF reader. Takes effect when the OME TIFF is opened for reading.
+         * @param enabled
+         */
+        void set_memory_mapping(bool enabled);
+
+        ome_write_buffer_format get_write_buffer_format() const;
+
+        /**
+         * Sets how written planes are stored until they are assembled into the OME TIFF.
+         * Can only be changed while no planes are buffered.
+         * @param format
+         */
+        void set_write_buffer_format(ome_write_buffer_format format);
+
+        /**
+         * Loads the planes of an interrupted run from the write buffer if the OME TIFF does not exist yet.
+         * Only planes that were written with the same write buffer format for the same metadata are restored.
+         * Must be called before any plane is written.
+         * @return Number of restored planes
+         */
+        size_t restore_write_buffer();
+
+        /**
+         * Number of reduced resolution levels that are stored for each plane of written OME TIFFs
+         * @return
+         */
+        size_t get_pyramid_levels() const;
+
+        /**
+         * Sets the number of reduced resolution levels that are stored as SubIFDs for each plane of written OME TIFFs.
+         * Each level halves the width and height of the previous level.
+         * Existing OME TIFFs are rewritten instead of being updated in place if levels are enabled.
+         * @param levels If zero, no reduced resolution levels are stored
+         */
+        void set_pyramid_levels(size_t levels);
+
+        /**
+         * Counters and durations of the IO operations since this IO was created or the statistics were reset.
+         * This method is thread-safe.
+         * @return
+         */
+        ome_tiff_io_statistics get_statistics() const;
+
+        void reset_statistics();
+
+        /**
+         * Maximum memory in bytes that is kept for recycling the pixel buffers used while planes are decoded and encoded.
+         * The pixel buffers are shared between all OME TIFFs.
+         * @return
+         */
+        size_t get_buffer_pool_capacity() const;
+
+        /**
+         * Sets the maximum memory in bytes that is kept for recycling pixel buffers.
+         * The limit is shared between all OME TIFFs. This method is thread-safe.
+         * @param capacity If zero, pixel buffers are allocated for each plane
+         */
+        void set_buffer_pool_capacity(size_t capacity);
+
     private:
 
         ome_tiff_io_impl *m_pimpl;
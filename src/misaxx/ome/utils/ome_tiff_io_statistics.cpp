@@ -0,0 +1,95 @@
+/**
+ * Copyright by Ruman Gerst
+ * Research Group Applied Systems Biology - Head: Prof. Dr. Marc Thilo Figge
+ * https://www.leibniz-hki.de/en/applied-systems-biology.html
+ * HKI-Center for Systems Biology of Infection
+ * Leibniz Institute for Natural Product Research and Infection Biology - Hans Knöll Insitute (HKI)
+ * Adolf-Reichwein-Straße 23, 07745 Jena, Germany
+ *
+ * This code is licensed under BSD 2-Clause
+ * See the LICENSE file provided with this code for the full license.
+ */
+
+#include "ome_tiff_io_statistics.h"
+
+using namespace misaxx::ome;
+
+namespace {
+    double to_seconds(uint64_t t_nanoseconds) {
+        return static_cast<double>(t_nanoseconds) / 1e9;
+    }
+}
+
+void ome_tiff_io_statistics::to_json(nlohmann::json &t_json) const {
+    t_json["bytes-read"] = bytes_read;
+    t_json["bytes-written"] = bytes_written;
+    t_json["planes-read"] = planes_read;
+    t_json["planes-decoded"] = planes_decoded;
+    t_json["planes-written"] = planes_written;
+    t_json["lock-wait-time"] = lock_wait_time;
+    t_json["decode-time"] = decode_time;
+    t_json["conversion-time"] = conversion_time;
+    t_json["write-buffer-read-time"] = write_buffer_read_time;
+    t_json["write-buffer-write-time"] = write_buffer_write_time;
+    t_json["close-writer-time"] = close_writer_time;
+}
+
+ome_tiff_io_statistics_recorder::scoped_timer::scoped_timer(ome_tiff_io_statistics_recorder &t_recorder,
+                                                            ome_tiff_io_timer t_timer) :
+        m_recorder(t_recorder), m_timer(t_timer), m_start(clock::now()) {
+
+}
+
+ome_tiff_io_statistics_recorder::scoped_timer::~scoped_timer() {
+    m_recorder.add_time(m_timer, clock::now() - m_start);
+}
+
+ome_tiff_io_statistics_recorder::scoped_timer ome_tiff_io_statistics_recorder::time(ome_tiff_io_timer t_timer) {
+    return scoped_timer(*this, t_timer);
+}
+
+void ome_tiff_io_statistics_recorder::add_time(ome_tiff_io_timer t_timer, clock::duration t_duration) {
+    const auto nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(t_duration).count();
+    m_times[static_cast<size_t>(t_timer)].fetch_add(static_cast<uint64_t>(nanoseconds), std::memory_order_relaxed);
+}
+
+void ome_tiff_io_statistics_recorder::add_read(uint64_t t_bytes) {
+    m_bytes_read.fetch_add(t_bytes, std::memory_order_relaxed);
+    m_planes_read.fetch_add(1, std::memory_order_relaxed);
+}
+
+void ome_tiff_io_statistics_recorder::add_decoded() {
+    m_planes_decoded.fetch_add(1, std::memory_order_relaxed);
+}
+
+void ome_tiff_io_statistics_recorder::add_written(uint64_t t_bytes) {
+    m_bytes_written.fetch_add(t_bytes, std::memory_order_relaxed);
+    m_planes_written.fetch_add(1, std::memory_order_relaxed);
+}
+
+ome_tiff_io_statistics ome_tiff_io_statistics_recorder::get() const {
+    ome_tiff_io_statistics result;
+    result.bytes_read = m_bytes_read.load(std::memory_order_relaxed);
+    result.bytes_written = m_bytes_written.load(std::memory_order_relaxed);
+    result.planes_read = m_planes_read.load(std::memory_order_relaxed);
+    result.planes_decoded = m_planes_decoded.load(std::memory_order_relaxed);
+    result.planes_written = m_planes_written.load(std::memory_order_relaxed);
+    result.lock_wait_time = to_seconds(m_times[static_cast<size_t>(ome_tiff_io_timer::lock_wait)].load(std::memory_order_relaxed));
+    result.decode_time = to_seconds(m_times[static_cast<size_t>(ome_tiff_io_timer::decode)].load(std::memory_order_relaxed));
+    result.conversion_time = to_seconds(m_times[static_cast<size_t>(ome_tiff_io_timer::conversion)].load(std::memory_order_relaxed));
+    result.write_buffer_read_time = to_seconds(m_times[static_cast<size_t>(ome_tiff_io_timer::write_buffer_read)].load(std::memory_order_relaxed));
+    result.write_buffer_write_time = to_seconds(m_times[static_cast<size_t>(ome_tiff_io_timer::write_buffer_write)].load(std::memory_order_relaxed));
+    result.close_writer_time = to_seconds(m_times[static_cast<size_t>(ome_tiff_io_timer::close_writer)].load(std::memory_order_relaxed));
+    return result;
+}
+
+void ome_tiff_io_statistics_recorder::reset() {
+    m_bytes_read = 0;
+    m_bytes_written = 0;
+    m_planes_read = 0;
+    m_planes_decoded = 0;
+    m_planes_written = 0;
+    for(auto &time : m_times) {
+        time = 0;
+    }
+}
@@ -0,0 +1,147 @@
+/**
+ * Copyright by Ruman Gerst
+ * Research Group Applied Systems Biology - Head: Prof. Dr. Marc Thilo Figge
+ * https://www.leibniz-hki.de/en/applied-systems-biology.html
+ * HKI-Center for Systems Biology of Infection
+ * Leibniz Institute for Natural Product Research and Infection Biology - Hans Knöll Insitute (HKI)
+ * Adolf-Reichwein-Straße 23, 07745 Jena, Germany
+ *
+ * This code is licensed under BSD 2-Clause
+ * See the LICENSE file provided with this code for the full license.
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <nlohmann/json.hpp>
+
+namespace misaxx::ome {
+
+    /**
+     * Operations of ome_tiff_io whose duration is measured
+     */
+    enum class ome_tiff_io_timer {
+        /**
+         * Waiting for the lock of the OME TIFF
+         */
+        lock_wait,
+        /**
+         * Decoding planes with the OME TIFF reader (openBytes)
+         */
+        decode,
+        /**
+         * Converting decoded planes into cv::Mat (ome_to_opencv)
+         */
+        conversion,
+        /**
+         * Reading planes from the write buffer
+         */
+        write_buffer_read,
+        /**
+         * Storing planes in the write buffer
+         */
+        write_buffer_write,
+        /**
+         * Assembling the OME TIFF from the write buffer (close_writer)
+         */
+        close_writer
+    };
+
+    /**
+     * Counters and accumulated durations of the IO operations of an ome_tiff_io
+     */
+    struct ome_tiff_io_statistics {
+        /**
+         * Pixel data returned by reads (in bytes)
+         */
+        uint64_t bytes_read = 0;
+        /**
+         * Pixel data passed to writes (in bytes)
+         */
+        uint64_t bytes_written = 0;
+        uint64_t planes_read = 0;
+        /**
+         * Planes (or regions of planes) that were decoded by the OME TIFF reader
+         */
+        uint64_t planes_decoded = 0;
+        uint64_t planes_written = 0;
+
+        /**
+         * Accumulated durations in seconds. Durations of operations that run in parallel are added up.
+         */
+        double lock_wait_time = 0;
+        double decode_time = 0;
+        double conversion_time = 0;
+        double write_buffer_read_time = 0;
+        double write_buffer_write_time = 0;
+        double close_writer_time = 0;
+
+        void to_json(nlohmann::json &t_json) const;
+    };
+
+    inline void to_json(nlohmann::json &j, const ome_tiff_io_statistics &p) {
+        p.to_json(j);
+    }
+
+    /**
+     * Thread-safe collection of IO statistics
+     */
+    class ome_tiff_io_statistics_recorder {
+    public:
+
+        using clock = std::chrono::steady_clock;
+
+        /**
+         * Adds the time between its creation and destruction to a timer
+         */
+        class scoped_timer {
+        public:
+            scoped_timer(ome_tiff_io_statistics_recorder &t_recorder, ome_tiff_io_timer t_timer);
+
+            ~scoped_timer();
+
+            scoped_timer(const scoped_timer &) = delete;
+
+            scoped_timer &operator=(const scoped_timer &) = delete;
+
+        private:
+            ome_tiff_io_statistics_recorder &m_recorder;
+            ome_tiff_io_timer m_timer;
+            clock::time_point m_start;
+        };
+
+        /**
+         * Measures the duration of an operation until the returned object is destroyed
+         * @param t_timer
+         * @return
+         */
+        scoped_timer time(ome_tiff_io_timer t_timer);
+
+        void add_time(ome_tiff_io_timer t_timer, clock::duration t_duration);
+
+        void add_read(uint64_t t_bytes);
+
+        void add_decoded();
+
+        void add_written(uint64_t t_bytes);
+
+        ome_tiff_io_statistics get() const;
+
+        void reset();
+
+    private:
+        std::atomic<uint64_t> m_bytes_read { 0 };
+        std::atomic<uint64_t> m_bytes_written { 0 };
+        std::atomic<uint64_t> m_planes_read { 0 };
+        std::atomic<uint64_t> m_planes_decoded { 0 };
+        std::atomic<uint64_t> m_planes_written { 0 };
+
+        /**
+         * Accumulated durations in nanoseconds
+         */
+        std::array<std::atomic<uint64_t>, 6> m_times {};
+    };
+}
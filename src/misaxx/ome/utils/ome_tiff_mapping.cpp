@@ -0,0 +1,200 @@
+/**
+ * Copyright by Ruman Gerst
+ * Research Group Applied Systems Biology - Head: Prof. Dr. Marc Thilo Figge
+ * https://www.leibniz-hki.de/en/applied-systems-biology.html
+ * HKI-Center for Systems Biology of Infection
+ * Leibniz Institute for Natural Product Research and Infection Biology - Hans Knöll Insitute (HKI)
+ * Adolf-Reichwein-Straße 23, 07745 Jena, Germany
+ *
+ * This code is licensed under BSD 2-Clause
+ * See the LICENSE file provided with this code for the full license.
+ */
+
+#include "ome_tiff_mapping.h"
+#include "ome_tiff_patch.h"
+#include "ome_to_opencv.h"
+#include <ome/files/PixelProperties.h>
+#include <tiffio.h>
+#include <algorithm>
+#include <cstring>
+
+using namespace misaxx::ome;
+
+namespace {
+
+    using tiff_handle = std::unique_ptr<TIFF, decltype(&TIFFClose)>;
+}
+
+std::shared_ptr<ome_tiff_mapping>
+ome_tiff_mapping::open(const boost::filesystem::path &t_path, const ::ome::xml::meta::OMEXMLMetadata &t_metadata) {
+    const auto plane_ifds = ome_tiff_get_plane_ifds(t_path, t_metadata);
+    if(!plane_ifds)
+        return nullptr;
+
+    // The directories are parsed in the order they are stored
+    std::multimap<::ome::files::dimension_size_type, misa_ome_plane_description> ifd_planes;
+    for(const auto &kv : *plane_ifds) {
+        ifd_planes.emplace(kv.second, kv.first);
+    }
+
+    std::shared_ptr<ome_tiff_mapping> result(new ome_tiff_mapping());
+    const uint64_t file_size = boost::filesystem::file_size(t_path);
+    {
+        tiff_handle tif(TIFFOpen(t_path.string().c_str(), "r"), &TIFFClose);
+        if(!tif)
+            return nullptr;
+
+        // The mapped data is not swapped
+        if(TIFFIsByteSwapped(tif.get()))
+            return nullptr;
+
+        auto it = ifd_planes.begin();
+        ::ome::files::dimension_size_type ifd = 0;
+        do {
+            for(; it != ifd_planes.end() && it->first == ifd; ++it) {
+                const misa_ome_plane_description &plane = it->second;
+
+                uint32_t width = 0;
+                uint32_t height = 0;
+                uint16_t bits_per_sample = 0;
+                uint16_t samples_per_pixel = 0;
+                uint16_t planar_config = PLANARCONFIG_CONTIG;
+                uint16_t compression = COMPRESSION_NONE;
+                TIFFGetField(tif.get(), TIFFTAG_IMAGEWIDTH, &width);
+                TIFFGetField(tif.get(), TIFFTAG_IMAGELENGTH, &height);
+                TIFFGetFieldDefaulted(tif.get(), TIFFTAG_BITSPERSAMPLE, &bits_per_sample);
+                TIFFGetFieldDefaulted(tif.get(), TIFFTAG_SAMPLESPERPIXEL, &samples_per_pixel);
+                TIFFGetFieldDefaulted(tif.get(), TIFFTAG_PLANARCONFIG, &planar_config);
+                TIFFGetFieldDefaulted(tif.get(), TIFFTAG_COMPRESSION, &compression);
+
+                if(compression != COMPRESSION_NONE || width == 0 || height == 0)
+                    continue;
+                if(planar_config != PLANARCONFIG_CONTIG && samples_per_pixel > 1)
+                    continue;
+                if(width != t_metadata.getPixelsSizeX(plane.series) || height != t_metadata.getPixelsSizeY(plane.series))
+                    continue;
+                if(bits_per_sample != ::ome::files::bitsPerPixel(t_metadata.getPixelsType(plane.series)) || bits_per_sample % 8 != 0)
+                    continue;
+                const int depth = ome_pixel_type_to_opencv_depth(t_metadata.getPixelsType(plane.series));
+                if(depth < 0 || samples_per_pixel == 0 || samples_per_pixel > CV_CN_MAX)
+                    continue;
+
+                plane_layout layout;
+                layout.width = static_cast<int>(width);
+                layout.height = static_cast<int>(height);
+                layout.opencv_type = CV_MAKETYPE(depth, samples_per_pixel);
+                layout.tiled = TIFFIsTiled(tif.get()) != 0;
+
+                const uint64_t pixel_bytes = static_cast<uint64_t>(samples_per_pixel) * (bits_per_sample / 8);
+                uint64_t *offsets = nullptr;
+                uint64_t *byte_counts = nullptr;
+                uint32_t num_chunks = 0;
+                if(layout.tiled) {
+                    TIFFGetField(tif.get(), TIFFTAG_TILEWIDTH, &layout.tile_width);
+                    TIFFGetField(tif.get(), TIFFTAG_TILELENGTH, &layout.tile_height);
+                    TIFFGetField(tif.get(), TIFFTAG_TILEOFFSETS, &offsets);
+                    TIFFGetField(tif.get(), TIFFTAG_TILEBYTECOUNTS, &byte_counts);
+                    num_chunks = TIFFNumberOfTiles(tif.get());
+                    if(layout.tile_width == 0 || layout.tile_height == 0)
+                        continue;
+                }
+                else {
+                    TIFFGetFieldDefaulted(tif.get(), TIFFTAG_ROWSPERSTRIP, &layout.rows_per_strip);
+                    TIFFGetField(tif.get(), TIFFTAG_STRIPOFFSETS, &offsets);
+                    TIFFGetField(tif.get(), TIFFTAG_STRIPBYTECOUNTS, &byte_counts);
+                    num_chunks = TIFFNumberOfStrips(tif.get());
+                    layout.rows_per_strip = std::min(layout.rows_per_strip, height);
+                    if(layout.rows_per_strip == 0)
+                        continue;
+                }
+                if(offsets == nullptr || byte_counts == nullptr)
+                    continue;
+
+                // Each strip or tile must be completely stored within the file
+                bool valid = true;
+                for(uint32_t i = 0; i < num_chunks && valid; ++i) {
+                    uint64_t chunk_bytes;
+                    if(layout.tiled) {
+                        chunk_bytes = static_cast<uint64_t>(layout.tile_width) * layout.tile_height * pixel_bytes;
+                    }
+                    else {
+                        const uint32_t rows = std::min(layout.rows_per_strip, height - std::min(height, i * layout.rows_per_strip));
+                        chunk_bytes = static_cast<uint64_t>(rows) * width * pixel_bytes;
+                    }
+                    valid = byte_counts[i] >= chunk_bytes && offsets[i] <= file_size && chunk_bytes <= file_size - offsets[i];
+                }
+                if(!valid)
+                    continue;
+
+                layout.offsets.assign(offsets, offsets + num_chunks);
+                result->m_planes.emplace(plane, std::move(layout));
+            }
+            ++ifd;
+        }
+        while(it != ifd_planes.end() && TIFFReadDirectory(tif.get()));
+    }
+
+    if(result->m_planes.empty())
+        return nullptr;
+
+    try {
+        result->m_file.open(t_path.string());
+    }
+    catch(const std::exception &) {
+        return nullptr;
+    }
+    if(!result->m_file.is_open())
+        return nullptr;
+    return result;
+}
+
+bool ome_tiff_mapping::contains(const misa_ome_plane_description &t_location) const {
+    return m_planes.find(t_location) != m_planes.end();
+}
+
+cv::Mat ome_tiff_mapping::read_plane(const misa_ome_plane_description &t_location) const {
+    const auto &layout = m_planes.at(t_location);
+    return read_plane_region(t_location, cv::Rect(0, 0, layout.width, layout.height));
+}
+
+cv::Mat ome_tiff_mapping::read_plane_region(const misa_ome_plane_description &t_location, const cv::Rect &t_region) const {
+    const auto &layout = m_planes.at(t_location);
+    cv::Mat result(t_region.height, t_region.width, layout.opencv_type);
+    const size_t pixel_bytes = result.elemSize();
+    const char *data = m_file.data();
+
+    if(!layout.tiled) {
+        const size_t row_bytes = layout.width * pixel_bytes;
+        for(int y = 0; y < t_region.height; ++y) {
+            const auto row = static_cast<uint32_t>(t_region.y + y);
+            const uint32_t strip = row / layout.rows_per_strip;
+            const char *src = data + layout.offsets[strip] + (row - strip * layout.rows_per_strip) * row_bytes + t_region.x * pixel_bytes;
+            std::memcpy(result.ptr(y), src, t_region.width * pixel_bytes);
+        }
+    }
+    else {
+        const size_t tile_row_bytes = layout.tile_width * pixel_bytes;
+        const uint32_t tiles_across = (static_cast<uint32_t>(layout.width) + layout.tile_width - 1) / layout.tile_width;
+        for(int y = 0; y < t_region.height; ++y) {
+            const auto row = static_cast<uint32_t>(t_region.y + y);
+            const uint32_t tile_y = row / layout.tile_height;
+            const uint32_t row_in_tile = row - tile_y * layout.tile_height;
+            uchar *dst = result.ptr(y);
+
+            // Copy the part of the row that is stored in each tile
+            auto x = static_cast<uint32_t>(t_region.x);
+            const auto end_x = static_cast<uint32_t>(t_region.x + t_region.width);
+            while(x < end_x) {
+                const uint32_t tile_x = x / layout.tile_width;
+                const uint32_t column_in_tile = x - tile_x * layout.tile_width;
+                const uint32_t columns = std::min(layout.tile_width - column_in_tile, end_x - x);
+                const char *src = data + layout.offsets[tile_y * tiles_across + tile_x] + row_in_tile * tile_row_bytes + column_in_tile * pixel_bytes;
+                std::memcpy(dst, src, columns * pixel_bytes);
+                dst += columns * pixel_bytes;
+                x += columns;
+            }
+        }
+    }
+
+    return result;
+}
@@ -0,0 +1,95 @@
+/**
+ * Copyright by Ruman Gerst
+ * Research Group Applied Systems Biology - Head: Prof. Dr. Marc Thilo Figge
+ * https://www.leibniz-hki.de/en/applied-systems-biology.html
+ * HKI-Center for Systems Biology of Infection
+ * Leibniz Institute for Natural Product Research and Infection Biology - Hans Knöll Insitute (HKI)
+ * Adolf-Reichwein-Straße 23, 07745 Jena, Germany
+ *
+ * This code is licensed under BSD 2-Clause
+ * See the LICENSE file provided with this code for the full license.
+ */
+
+#pragma once
+
+#include <map>
+#include <memory>
+#include <vector>
+#include <boost/filesystem.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
+#include <opencv2/opencv.hpp>
+#include <ome/xml/meta/OMEXMLMetadata.h>
+#include <misaxx/ome/descriptions/misa_ome_plane_description.h>
+
+namespace misaxx::ome {
+
+    /**
+     * Reads planes of a single-file OME TIFF from a memory mapping of the file.
+     * Only planes that are stored uncompressed, in the byte order of this machine and with interleaved samples
+     * can be read. Their strip or tile offsets are parsed once when the mapping is opened, so reading a plane
+     * only copies the rows from the mapping into the cv::Mat.
+     *
+     * The file must not be modified while it is mapped.
+     */
+    class ome_tiff_mapping {
+    public:
+
+        ome_tiff_mapping(const ome_tiff_mapping &) = delete;
+
+        ome_tiff_mapping &operator=(const ome_tiff_mapping &) = delete;
+
+        /**
+         * Maps an OME TIFF into memory
+         * @param t_path Path of the OME TIFF
+         * @param t_metadata Metadata of the OME TIFF
+         * @return nullptr if no plane of the OME TIFF can be read from a memory mapping
+         */
+        static std::shared_ptr<ome_tiff_mapping> open(const boost::filesystem::path &t_path, const ::ome::xml::meta::OMEXMLMetadata &t_metadata);
+
+        /**
+         * Returns true if the plane can be read from the mapping
+         * @param t_location
+         * @return
+         */
+        bool contains(const misa_ome_plane_description &t_location) const;
+
+        /**
+         * Copies a plane from the mapping
+         * @param t_location Must be contained in the mapping
+         * @return
+         */
+        cv::Mat read_plane(const misa_ome_plane_description &t_location) const;
+
+        /**
+         * Copies a region of a plane from the mapping
+         * @param t_location Must be contained in the mapping
+         * @param t_region Region within the plane. Must be located within the plane.
+         * @return
+         */
+        cv::Mat read_plane_region(const misa_ome_plane_description &t_location, const cv::Rect &t_region) const;
+
+    private:
+
+        /**
+         * Location of the image data of a plane within the file
+         */
+        struct plane_layout {
+            int width = 0;
+            int height = 0;
+            int opencv_type = 0;
+            bool tiled = false;
+            uint32_t rows_per_strip = 0;
+            uint32_t tile_width = 0;
+            uint32_t tile_height = 0;
+            /**
+             * File offset of each strip or tile
+             */
+            std::vector<uint64_t> offsets;
+        };
+
+        ome_tiff_mapping() = default;
+
+        boost::iostreams::mapped_file_source m_file;
+        std::map<misa_ome_plane_description, plane_layout> m_planes;
+    };
+}
@@ -0,0 +1,220 @@
+/**
+ * Copyright by Ruman Gerst
+ * Research Group Applied Systems Biology - Head: Prof. Dr. Marc Thilo Figge
+ * https://www.leibniz-hki.de/en/applied-systems-biology.html
+ * HKI-Center for Systems Biology of Infection
+ * Leibniz Institute for Natural Product Research and Infection Biology - Hans Knöll Insitute (HKI)
+ * Adolf-Reichwein-Straße 23, 07745 Jena, Germany
+ *
+ * This code is licensed under BSD 2-Clause
+ * See the LICENSE file provided with this code for the full license.
+ */
+
+#include "ome_tiff_patch.h"
+#include <misaxx/ome/utils/ome_helpers.h>
+#include <misaxx/core/utils/string.h>
+#include <ome/files/PixelProperties.h>
+#include <tiffio.h>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <optional>
+
+using namespace misaxx::ome;
+
+namespace {
+
+    using tiff_handle = std::unique_ptr<TIFF, decltype(&TIFFClose)>;
+
+    /**
+     * Layout of the image data stored in a TIFF directory
+     */
+    struct tiff_plane_layout {
+        uint32_t width = 0;
+        uint32_t height = 0;
+        uint16_t bits_per_sample = 0;
+        uint16_t samples_per_pixel = 0;
+        uint16_t planar_config = PLANARCONFIG_CONTIG;
+        bool tiled = false;
+        uint32_t rows_per_strip = 0;
+        uint32_t tile_width = 0;
+        uint32_t tile_height = 0;
+
+        explicit tiff_plane_layout(TIFF *tif) {
+            TIFFGetField(tif, TIFFTAG_IMAGEWIDTH, &width);
+            TIFFGetField(tif, TIFFTAG_IMAGELENGTH, &height);
+            TIFFGetFieldDefaulted(tif, TIFFTAG_BITSPERSAMPLE, &bits_per_sample);
+            TIFFGetFieldDefaulted(tif, TIFFTAG_SAMPLESPERPIXEL, &samples_per_pixel);
+            TIFFGetFieldDefaulted(tif, TIFFTAG_PLANARCONFIG, &planar_config);
+            tiled = TIFFIsTiled(tif) != 0;
+            if(tiled) {
+                TIFFGetField(tif, TIFFTAG_TILEWIDTH, &tile_width);
+                TIFFGetField(tif, TIFFTAG_TILELENGTH, &tile_height);
+            }
+            else {
+                TIFFGetFieldDefaulted(tif, TIFFTAG_ROWSPERSTRIP, &rows_per_strip);
+            }
+        }
+
+        /**
+         * Number of samples that are stored together in one strip or tile
+         * @return
+         */
+        uint16_t get_interleaved_samples() const {
+            return planar_config == PLANARCONFIG_SEPARATE ? static_cast<uint16_t>(1) : samples_per_pixel;
+        }
+    };
+
+    /**
+     * Encodes image data that contains the interleaved samples of one strip or tile column into the current directory
+     * @param tif
+     * @param layout
+     * @param data Continuous image that contains the samples stored in the strips / tiles
+     * @param sample The sample plane (only relevant for separate planar configuration)
+     */
+    void write_sample_data(TIFF *tif, const tiff_plane_layout &layout, cv::Mat &data, uint16_t sample) {
+        const size_t pixel_bytes = layout.get_interleaved_samples() * (layout.bits_per_sample / 8);
+        const size_t row_bytes = layout.width * pixel_bytes;
+
+        if(!layout.tiled) {
+            for(uint32_t y = 0; y < layout.height; y += layout.rows_per_strip) {
+                const uint32_t rows = std::min(layout.rows_per_strip, layout.height - y);
+                const auto strip = TIFFComputeStrip(tif, y, sample);
+                if(TIFFWriteEncodedStrip(tif, strip, data.ptr<uchar>(static_cast<int>(y)), rows * row_bytes) < 0)
+                    throw std::runtime_error("Could not write TIFF strip!");
+            }
+        }
+        else {
+            const size_t tile_row_bytes = layout.tile_width * pixel_bytes;
+            std::vector<uchar> tile(tile_row_bytes * layout.tile_height);
+            for(uint32_t y = 0; y < layout.height; y += layout.tile_height) {
+                for(uint32_t x = 0; x < layout.width; x += layout.tile_width) {
+                    // Edge tiles are padded
+                    std::fill(tile.begin(), tile.end(), 0);
+                    const uint32_t rows = std::min(layout.tile_height, layout.height - y);
+                    const size_t copied_row_bytes = std::min(layout.tile_width, layout.width - x) * pixel_bytes;
+                    for(uint32_t r = 0; r < rows; ++r) {
+                        std::memcpy(tile.data() + r * tile_row_bytes, data.ptr<uchar>(static_cast<int>(y + r)) + x * pixel_bytes, copied_row_bytes);
+                    }
+                    const auto tile_index = TIFFComputeTile(tif, x, y, 0, sample);
+                    if(TIFFWriteEncodedTile(tif, tile_index, tile.data(), tile.size()) < 0)
+                        throw std::runtime_error("Could not write TIFF tile!");
+                }
+            }
+        }
+    }
+}
+
+std::optional<std::map<misa_ome_plane_description, ::ome::files::dimension_size_type>>
+misaxx::ome::ome_tiff_get_plane_ifds(const boost::filesystem::path &t_path, const ::ome::xml::meta::OMEXMLMetadata &t_metadata) {
+    std::map<misa_ome_plane_description, ::ome::files::dimension_size_type> result;
+    try {
+        for(size_t series = 0; series < t_metadata.getImageCount(); ++series) {
+            for(size_t td = 0; td < t_metadata.getTiffDataCount(series); ++td) {
+                const boost::filesystem::path file_name = t_metadata.getUUIDFileName(series, td);
+                if(file_name.filename() != t_path.filename())
+                    return std::nullopt;
+                const ::ome::files::dimension_size_type ifd = t_metadata.getTiffDataIFD(series, td);
+                const ::ome::files::dimension_size_type plane_count = t_metadata.getTiffDataPlaneCount(series, td);
+                const auto first_index = helpers::get_plane_index(t_metadata, series,
+                        t_metadata.getTiffDataFirstZ(series, td),
+                        t_metadata.getTiffDataFirstC(series, td),
+                        t_metadata.getTiffDataFirstT(series, td));
+                for(::ome::files::dimension_size_type i = 0; i < plane_count; ++i) {
+                    const auto zct = helpers::get_plane_zct(t_metadata, series, first_index + i);
+                    result[misa_ome_plane_description(series, zct[0], zct[1], zct[2])] = ifd + i;
+                }
+            }
+        }
+    }
+    catch(const std::exception &) {
+        // Missing TiffData attributes
+        return std::nullopt;
+    }
+    return result;
+}
+
+bool misaxx::ome::ome_tiff_patch_planes(const boost::filesystem::path &t_path,
+                                        const ::ome::xml::meta::OMEXMLMetadata &t_metadata,
+                                        const std::vector<misa_ome_plane_description> &t_planes,
+                                        const ome_tiff_compression &t_compression,
+                                        const ome_tiff_plane_loader &t_loader) {
+    const auto plane_ifds = ome_tiff_get_plane_ifds(t_path, t_metadata);
+    if(!plane_ifds)
+        return false;
+
+    std::vector<tdir_t> ifds;
+    for(const auto &plane : t_planes) {
+        const auto it = plane_ifds->find(plane);
+        if(it == plane_ifds->end() || it->second > std::numeric_limits<tdir_t>::max())
+            return false;
+        ifds.push_back(static_cast<tdir_t>(it->second));
+    }
+
+    tiff_handle tif(TIFFOpen(t_path.string().c_str(), "r+"), &TIFFClose);
+    if(!tif)
+        return false;
+
+    // libtiff swaps the buffers that are passed to it
+    if(TIFFIsByteSwapped(tif.get()))
+        return false;
+
+    // Check all planes before anything is modified
+    for(size_t i = 0; i < t_planes.size(); ++i) {
+        const auto &plane = t_planes[i];
+        if(!TIFFSetDirectory(tif.get(), ifds[i]))
+            return false;
+        const tiff_plane_layout layout(tif.get());
+        if(layout.width != t_metadata.getPixelsSizeX(plane.series) || layout.height != t_metadata.getPixelsSizeY(plane.series))
+            return false;
+        if(layout.bits_per_sample != ::ome::files::bitsPerPixel(t_metadata.getPixelsType(plane.series)) || layout.bits_per_sample % 8 != 0)
+            return false;
+        if(layout.samples_per_pixel != t_metadata.getChannelSamplesPerPixel(plane.series, plane.c))
+            return false;
+
+        // Reduced resolution levels would not match the modified plane
+        uint16_t num_levels = 0;
+        uint64_t *level_offsets = nullptr;
+        if(TIFFGetField(tif.get(), TIFFTAG_SUBIFD, &num_levels, &level_offsets) && num_levels > 0)
+            return false;
+    }
+
+    for(size_t i = 0; i < t_planes.size(); ++i) {
+        if(!TIFFSetDirectory(tif.get(), ifds[i]))
+            throw std::runtime_error("Could not open TIFF directory " + std::to_string(ifds[i]) + " of " + t_path.string());
+        const tiff_plane_layout layout(tif.get());
+
+        cv::Mat image = t_loader(t_planes[i]);
+        if(image.cols != static_cast<int>(layout.width) || image.rows != static_cast<int>(layout.height) ||
+           image.channels() != layout.samples_per_pixel || image.elemSize1() * 8 != layout.bits_per_sample) {
+            throw std::runtime_error("The plane " + misaxx::utils::to_string(t_planes[i]) + " does not match the layout of " + t_path.string());
+        }
+        if(!image.isContinuous()) {
+            image = image.clone();
+        }
+
+        // The compression codec of the directory is kept
+        uint16_t scheme = COMPRESSION_NONE;
+        TIFFGetFieldDefaulted(tif.get(), TIFFTAG_COMPRESSION, &scheme);
+        if(t_compression.is_enabled() && t_compression.is_supported() && static_cast<int>(scheme) == ome_tiff_get_compression_scheme(t_compression.codec)) {
+            ome_tiff_set_compression_fields(tif.get(), image.depth(), t_compression);
+        }
+
+        if(layout.get_interleaved_samples() == layout.samples_per_pixel) {
+            write_sample_data(tif.get(), layout, image, 0);
+        }
+        else {
+            for(uint16_t sample = 0; sample < layout.samples_per_pixel; ++sample) {
+                cv::Mat channel;
+                cv::extractChannel(image, channel, sample);
+                write_sample_data(tif.get(), layout, channel, sample);
+            }
+        }
+
+        if(!TIFFRewriteDirectory(tif.get()))
+            throw std::runtime_error("Could not update TIFF directory " + std::to_string(ifds[i]) + " of " + t_path.string());
+    }
+
+    return true;
+}
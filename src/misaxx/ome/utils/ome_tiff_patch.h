@@ -0,0 +1,59 @@
+/**
+ * Copyright by Ruman Gerst
+ * Research Group Applied Systems Biology - Head: Prof. Dr. Marc Thilo Figge
+ * https://www.leibniz-hki.de/en/applied-systems-biology.html
+ * HKI-Center for Systems Biology of Infection
+ * Leibniz Institute for Natural Product Research and Infection Biology - Hans Knöll Insitute (HKI)
+ * Adolf-Reichwein-Straße 23, 07745 Jena, Germany
+ *
+ * This code is licensed under BSD 2-Clause
+ * See the LICENSE file provided with this code for the full license.
+ */
+
+#pragma once
+
+#include <functional>
+#include <map>
+#include <optional>
+#include <vector>
+#include <boost/filesystem.hpp>
+#include <opencv2/opencv.hpp>
+#include <ome/xml/meta/OMEXMLMetadata.h>
+#include <misaxx/ome/descriptions/misa_ome_plane_description.h>
+#include "ome_tiff_compression.h"
+
+namespace misaxx::ome {
+
+    /**
+     * Function that loads the new content of a plane
+     */
+    using ome_tiff_plane_loader = std::function<cv::Mat(const misa_ome_plane_description &)>;
+
+    /**
+     * Maps each plane of a single-file OME TIFF to the IFD that contains it
+     * @param t_path Path of the OME TIFF
+     * @param t_metadata Metadata of the OME TIFF
+     * @return Nothing if any plane is stored in another file or the TiffData is incomplete
+     */
+    extern std::optional<std::map<misa_ome_plane_description, ::ome::files::dimension_size_type>>
+    ome_tiff_get_plane_ifds(const boost::filesystem::path &t_path, const ::ome::xml::meta::OMEXMLMetadata &t_metadata);
+
+    /**
+     * Overwrites planes of an existing single-file OME TIFF without rewriting the other planes.
+     * The strips or tiles of each plane are encoded with the compression that is stored in the TIFF.
+     * If the stored codec is the codec of the compression settings, the level and predictor of the settings are applied.
+     * Data that fits into the existing strips or tiles is written in place. Otherwise it is appended to the file.
+     * Only the directories of the modified planes are updated.
+     * @param t_path Path of the OME TIFF
+     * @param t_metadata Metadata of the OME TIFF
+     * @param t_planes The planes that should be overwritten
+     * @param t_compression Compression settings of written planes
+     * @param t_loader Function that loads the new content of a plane
+     * @return False if the layout of the OME TIFF does not allow updating planes. The file is not modified in this case.
+     */
+    extern bool ome_tiff_patch_planes(const boost::filesystem::path &t_path,
+            const ::ome::xml::meta::OMEXMLMetadata &t_metadata,
+            const std::vector<misa_ome_plane_description> &t_planes,
+            const ome_tiff_compression &t_compression,
+            const ome_tiff_plane_loader &t_loader);
+}
@@ -0,0 +1,176 @@
+/**
+ * Copyright by Ruman Gerst
+ * Research Group Applied Systems Biology - Head: Prof. Dr. Marc Thilo Figge
+ * https://www.leibniz-hki.de/en/applied-systems-biology.html
+ * HKI-Center for Systems Biology of Infection
+ * Leibniz Institute for Natural Product Research and Infection Biology - Hans Knöll Insitute (HKI)
+ * Adolf-Reichwein-Straße 23, 07745 Jena, Germany
+ *
+ * This code is licensed under BSD 2-Clause
+ * See the LICENSE file provided with this code for the full license.
+ */
+
+#include "ome_tiff_pyramid.h"
+#include "ome_tiff_patch.h"
+#include <misaxx/core/utils/string.h>
+#include <ome/files/MetadataTools.h>
+#include <tiffio.h>
+#include <algorithm>
+#include <limits>
+
+using namespace misaxx::ome;
+
+namespace {
+
+    using tiff_handle = std::unique_ptr<TIFF, decltype(&TIFFClose)>;
+}
+
+std::shared_ptr<ome_tiff_pyramid>
+ome_tiff_pyramid::open(const boost::filesystem::path &t_path, const ::ome::xml::meta::OMEXMLMetadata &t_metadata) {
+    const auto plane_ifds = ome_tiff_get_plane_ifds(t_path, t_metadata);
+    if(!plane_ifds)
+        return nullptr;
+
+    // The directories are parsed in the order they are stored
+    std::multimap<::ome::files::dimension_size_type, misa_ome_plane_description> ifd_planes;
+    for(const auto &kv : *plane_ifds) {
+        ifd_planes.emplace(kv.second, kv.first);
+    }
+
+    std::shared_ptr<ome_tiff_pyramid> result(new ome_tiff_pyramid());
+    result->m_path = t_path;
+
+    tiff_handle tif(TIFFOpen(t_path.string().c_str(), "r"), &TIFFClose);
+    if(!tif)
+        return nullptr;
+
+    auto it = ifd_planes.begin();
+    ::ome::files::dimension_size_type ifd = 0;
+    do {
+        for(; it != ifd_planes.end() && it->first == ifd; ++it) {
+            uint16_t num_levels = 0;
+            uint64_t *offsets = nullptr;
+            if(TIFFGetField(tif.get(), TIFFTAG_SUBIFD, &num_levels, &offsets) && num_levels > 0 && offsets != nullptr) {
+                result->m_levels[it->second].assign(offsets, offsets + num_levels);
+            }
+        }
+        ++ifd;
+    }
+    while(it != ifd_planes.end() && TIFFReadDirectory(tif.get()));
+
+    if(result->m_levels.empty())
+        return nullptr;
+    return result;
+}
+
+size_t ome_tiff_pyramid::get_num_levels(const misa_ome_plane_description &t_location) const {
+    const auto it = m_levels.find(t_location);
+    return it != m_levels.end() ? it->second.size() : 0;
+}
+
+cv::Mat ome_tiff_pyramid::read_level(const misa_ome_plane_description &t_location, size_t t_level) const {
+    if(t_level == 0 || t_level > get_num_levels(t_location))
+        return cv::Mat();
+
+    // Each call uses its own handle, so levels can be read concurrently
+    tiff_handle tif(TIFFOpen(m_path.string().c_str(), "r"), &TIFFClose);
+    if(!tif || !TIFFSetSubDirectory(tif.get(), m_levels.at(t_location)[t_level - 1]))
+        return cv::Mat();
+
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint16_t bits_per_sample = 0;
+    uint16_t samples_per_pixel = 0;
+    uint16_t sample_format = SAMPLEFORMAT_UINT;
+    uint16_t planar_config = PLANARCONFIG_CONTIG;
+    uint32_t rows_per_strip = 0;
+    TIFFGetField(tif.get(), TIFFTAG_IMAGEWIDTH, &width);
+    TIFFGetField(tif.get(), TIFFTAG_IMAGELENGTH, &height);
+    TIFFGetFieldDefaulted(tif.get(), TIFFTAG_BITSPERSAMPLE, &bits_per_sample);
+    TIFFGetFieldDefaulted(tif.get(), TIFFTAG_SAMPLESPERPIXEL, &samples_per_pixel);
+    TIFFGetFieldDefaulted(tif.get(), TIFFTAG_SAMPLEFORMAT, &sample_format);
+    TIFFGetFieldDefaulted(tif.get(), TIFFTAG_PLANARCONFIG, &planar_config);
+    TIFFGetFieldDefaulted(tif.get(), TIFFTAG_ROWSPERSTRIP, &rows_per_strip);
+
+    // Levels are written as contiguous strips
+    const int depth = ome_tiff_get_opencv_depth(bits_per_sample, sample_format);
+    if(width == 0 || height == 0 || depth < 0 || samples_per_pixel == 0 || samples_per_pixel > CV_CN_MAX || TIFFIsTiled(tif.get()))
+        return cv::Mat();
+    if(planar_config != PLANARCONFIG_CONTIG && samples_per_pixel > 1)
+        return cv::Mat();
+    rows_per_strip = std::min(std::max<uint32_t>(1, rows_per_strip), height);
+
+    cv::Mat result(static_cast<int>(height), static_cast<int>(width), CV_MAKETYPE(depth, samples_per_pixel));
+    const size_t row_bytes = width * result.elemSize();
+    for(uint32_t y = 0; y < height; y += rows_per_strip) {
+        const uint32_t rows = std::min(rows_per_strip, height - y);
+        if(TIFFReadEncodedStrip(tif.get(), TIFFComputeStrip(tif.get(), y, 0), result.ptr(static_cast<int>(y)), rows * row_bytes) < 0)
+            return cv::Mat();
+    }
+    return result;
+}
+
+cv::Mat misaxx::ome::ome_tiff_downsample(const cv::Mat &t_image) {
+    const cv::Size size((t_image.cols + 1) / 2, (t_image.rows + 1) / 2);
+    cv::Mat result;
+    if(t_image.depth() == CV_8S || t_image.depth() == CV_32S) {
+        // Area interpolation does not support these depths
+        cv::Mat converted;
+        t_image.convertTo(converted, CV_64F);
+        cv::resize(converted, converted, size, 0, 0, cv::INTER_AREA);
+        converted.convertTo(result, t_image.depth());
+    }
+    else {
+        cv::resize(t_image, result, size, 0, 0, cv::INTER_AREA);
+    }
+    return result;
+}
+
+void misaxx::ome::ome_tiff_write_pyramid(const boost::filesystem::path &t_path,
+                                         const std::vector<misa_ome_plane_description> &t_planes,
+                                         size_t t_num_levels,
+                                         const ome_tiff_compression &t_compression,
+                                         const ome_tiff_level_loader &t_loader) {
+    // The TiffData of the written file is required to find the planes
+    const auto metadata = ::ome::files::createOMEXMLMetadata(t_path);
+    const auto plane_ifds = ome_tiff_get_plane_ifds(t_path, *metadata);
+    if(!plane_ifds)
+        throw std::runtime_error("Could not locate the planes of " + t_path.string());
+
+    std::vector<std::pair<tdir_t, misa_ome_plane_description>> planes;
+    for(const auto &plane : t_planes) {
+        const auto it = plane_ifds->find(plane);
+        if(it == plane_ifds->end() || it->second > std::numeric_limits<tdir_t>::max())
+            throw std::runtime_error("Could not locate the plane " + misaxx::utils::to_string(plane) + " in " + t_path.string());
+        planes.emplace_back(static_cast<tdir_t>(it->second), plane);
+    }
+    std::sort(planes.begin(), planes.end());
+
+    tiff_handle tif(TIFFOpen(t_path.string().c_str(), "r+"), &TIFFClose);
+    if(!tif)
+        throw std::runtime_error("Could not open " + t_path.string() + " for writing!");
+
+    for(const auto &kv : planes) {
+        std::vector<cv::Mat> levels;
+        for(size_t level = 1; level <= t_num_levels; ++level) {
+            levels.emplace_back(t_loader(kv.second, level));
+        }
+        if(levels.empty())
+            continue;
+
+        // libtiff fills the SubIFD offsets while the following directories are written
+        if(!TIFFSetDirectory(tif.get(), kv.first))
+            throw std::runtime_error("Could not open TIFF directory " + std::to_string(kv.first) + " of " + t_path.string());
+        std::vector<toff_t> offsets(levels.size(), 0);
+        TIFFSetField(tif.get(), TIFFTAG_SUBIFD, static_cast<uint16_t>(offsets.size()), offsets.data());
+        if(!TIFFRewriteDirectory(tif.get()))
+            throw std::runtime_error("Could not write TIFF directory " + std::to_string(kv.first) + " of " + t_path.string());
+
+        for(const cv::Mat &level : levels) {
+            TIFFSetField(tif.get(), TIFFTAG_SUBFILETYPE, FILETYPE_REDUCEDIMAGE);
+            ome_tiff_write_image(tif.get(), level, t_compression);
+            if(!TIFFWriteDirectory(tif.get()))
+                throw std::runtime_error("Could not write reduced resolution level of " + misaxx::utils::to_string(kv.second) + " into " + t_path.string());
+        }
+    }
+}
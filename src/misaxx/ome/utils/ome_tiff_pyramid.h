@@ -0,0 +1,96 @@
+/**
+ * Copyright by Ruman Gerst
+ * Research Group Applied Systems Biology - Head: Prof. Dr. Marc Thilo Figge
+ * https://www.leibniz-hki.de/en/applied-systems-biology.html
+ * HKI-Center for Systems Biology of Infection
+ * Leibniz Institute for Natural Product Research and Infection Biology - Hans Knöll Insitute (HKI)
+ * Adolf-Reichwein-Straße 23, 07745 Jena, Germany
+ *
+ * This code is licensed under BSD 2-Clause
+ * See the LICENSE file provided with this code for the full license.
+ */
+
+#pragma once
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <vector>
+#include <boost/filesystem.hpp>
+#include <opencv2/opencv.hpp>
+#include <ome/xml/meta/OMEXMLMetadata.h>
+#include <misaxx/ome/descriptions/misa_ome_plane_description.h>
+#include "ome_tiff_compression.h"
+
+namespace misaxx::ome {
+
+    /**
+     * Function that loads a reduced resolution level (starting at 1) of a plane
+     */
+    using ome_tiff_level_loader = std::function<cv::Mat(const misa_ome_plane_description &, size_t)>;
+
+    /**
+     * Reduced resolution levels of the planes within a single-file OME TIFF.
+     * The levels are stored as SubIFDs of the IFD that contains the full resolution plane.
+     * Each level halves the width and height of the previous level.
+     */
+    class ome_tiff_pyramid {
+    public:
+
+        /**
+         * Finds the reduced resolution levels of all planes
+         * @param t_path Path of the OME TIFF
+         * @param t_metadata Metadata of the OME TIFF
+         * @return nullptr if no plane has reduced resolution levels
+         */
+        static std::shared_ptr<ome_tiff_pyramid> open(const boost::filesystem::path &t_path, const ::ome::xml::meta::OMEXMLMetadata &t_metadata);
+
+        /**
+         * Number of reduced resolution levels that are stored for a plane
+         * @param t_location
+         * @return
+         */
+        size_t get_num_levels(const misa_ome_plane_description &t_location) const;
+
+        /**
+         * Reads a reduced resolution level of a plane. This method is thread-safe.
+         * @param t_location
+         * @param t_level Level starting at 1
+         * @return An empty image if the level is not stored or cannot be read
+         */
+        cv::Mat read_level(const misa_ome_plane_description &t_location, size_t t_level) const;
+
+    private:
+
+        ome_tiff_pyramid() = default;
+
+        boost::filesystem::path m_path;
+
+        /**
+         * Offsets of the SubIFDs of each plane
+         */
+        std::map<misa_ome_plane_description, std::vector<uint64_t>> m_levels;
+    };
+
+    /**
+     * Halves the width and height of an image by averaging
+     * @param t_image
+     * @return
+     */
+    extern cv::Mat ome_tiff_downsample(const cv::Mat &t_image);
+
+    /**
+     * Stores reduced resolution levels of planes as SubIFDs into a single-file OME TIFF that was completely written.
+     * The directories of the planes are rewritten. The pixel data of the planes is not modified.
+     * @param t_path Path of the OME TIFF
+     * @param t_planes Planes that get reduced resolution levels
+     * @param t_num_levels Number of reduced resolution levels of each plane
+     * @param t_compression Compression of the reduced resolution levels
+     * @param t_loader Function that loads a reduced resolution level
+     */
+    extern void ome_tiff_write_pyramid(const boost::filesystem::path &t_path,
+            const std::vector<misa_ome_plane_description> &t_planes,
+            size_t t_num_levels,
+            const ome_tiff_compression &t_compression,
+            const ome_tiff_level_loader &t_loader);
+}
@@ -0,0 +1,126 @@
+/**
+ * Copyright by Ruman Gerst
+ * Research Group Applied Systems Biology - Head: Prof. Dr. Marc Thilo Figge
+ * https://www.leibniz-hki.de/en/applied-systems-biology.html
+ * HKI-Center for Systems Biology of Infection
+ * Leibniz Institute for Natural Product Research and Infection Biology - Hans Knöll Insitute (HKI)
+ * Adolf-Reichwein-Straße 23, 07745 Jena, Germany
+ *
+ * This code is licensed under BSD 2-Clause
+ * See the LICENSE file provided with this code for the full license.
+ */
+
+
+#include "ome_tiff_writer.h"
+#include "ome_to_opencv.h"
+#include <misaxx/ome/utils/ome_helpers.h>
+#include <ome/files/MetadataTools.h>
+#include <boost/uuid/uuid.hpp>
+#include <boost/uuid/uuid_generators.hpp>
+#include <boost/uuid/uuid_io.hpp>
+#include <algorithm>
+
+using namespace misaxx::ome;
+
+namespace {
+
+    /**
+     * Creates the OME XML of a single-file OME TIFF that stores each plane in its own IFD
+     * @param t_path
+     * @param t_metadata
+     * @return
+     */
+    std::string create_ome_xml(const boost::filesystem::path &t_path, const std::shared_ptr<::ome::xml::meta::OMEXMLMetadata> &t_metadata) {
+        // The TiffData is modified on a copy, as the metadata is shared with readers
+        const auto metadata = ::ome::files::createOMEXMLMetadata(t_metadata->dumpXML());
+
+        // TiffData of the source would reference other files or IFDs
+        ::ome::files::removeTiffData(*metadata);
+
+        const std::string uuid = "urn:uuid:" + boost::uuids::to_string(boost::uuids::random_generator()());
+        metadata->setUUID(uuid);
+
+        ::ome::files::dimension_size_type ifd = 0;
+        for(size_t series = 0; series < metadata->getImageCount(); ++series) {
+            const auto num_planes = static_cast<::ome::files::dimension_size_type>(metadata->getPixelsSizeZ(series)) *
+                                    static_cast<::ome::files::dimension_size_type>(metadata->getChannelCount(series)) *
+                                    static_cast<::ome::files::dimension_size_type>(metadata->getPixelsSizeT(series));
+            for(::ome::files::dimension_size_type plane = 0; plane < num_planes; ++plane) {
+                const auto zct = helpers::get_plane_zct(*metadata, series, plane);
+                metadata->setTiffDataIFD(ifd, series, plane);
+                metadata->setTiffDataFirstZ(zct[0], series, plane);
+                metadata->setTiffDataFirstC(zct[1], series, plane);
+                metadata->setTiffDataFirstT(zct[2], series, plane);
+                metadata->setTiffDataPlaneCount(1, series, plane);
+                metadata->setUUIDFileName(t_path.filename().string(), series, plane);
+                metadata->setUUIDValue(uuid, series, plane);
+                ++ifd;
+            }
+        }
+        return metadata->dumpXML();
+    }
+
+    /**
+     * Rows, columns and OpenCV type of each plane in the order they are stored within the OME TIFF
+     * @param t_metadata
+     * @return
+     */
+    std::vector<std::tuple<int, int, int>> get_plane_layouts(const ::ome::xml::meta::OMEXMLMetadata &t_metadata) {
+        std::vector<std::tuple<int, int, int>> result;
+        for(size_t series = 0; series < t_metadata.getImageCount(); ++series) {
+            const int depth = ome_pixel_type_to_opencv_depth(t_metadata.getPixelsType(series));
+            const auto num_planes = static_cast<::ome::files::dimension_size_type>(t_metadata.getPixelsSizeZ(series)) *
+                                    static_cast<::ome::files::dimension_size_type>(t_metadata.getChannelCount(series)) *
+                                    static_cast<::ome::files::dimension_size_type>(t_metadata.getPixelsSizeT(series));
+            for(::ome::files::dimension_size_type plane = 0; plane < num_planes; ++plane) {
+                const auto c = helpers::get_plane_zct(t_metadata, series, plane)[1];
+                const auto samples_per_pixel = static_cast<int>(t_metadata.getChannelSamplesPerPixel(series, c));
+                result.emplace_back(static_cast<int>(t_metadata.getPixelsSizeY(series)), static_cast<int>(t_metadata.getPixelsSizeX(series)),
+                                    depth < 0 ? -1 : CV_MAKETYPE(depth, samples_per_pixel));
+            }
+        }
+        return result;
+    }
+}
+
+ome_tiff_writer::ome_tiff_writer(boost::filesystem::path t_path, const std::shared_ptr<::ome::xml::meta::OMEXMLMetadata> &t_metadata,
+                                 ome_tiff_compression t_compression, ::ome::files::dimension_size_type t_tile_size,
+                                 std::shared_ptr<ome_worker_pool> t_workers) :
+        m_path(std::move(t_path)), m_compression(std::move(t_compression)), m_tile_size(static_cast<uint32_t>(t_tile_size)),
+        m_workers(std::move(t_workers)), m_tif(nullptr, &TIFFClose), m_ome_xml(create_ome_xml(m_path, t_metadata)),
+        m_plane_layouts(get_plane_layouts(*t_metadata)) {
+    // OME TIFFs are always written as BigTIFF
+    m_tif.reset(TIFFOpen(m_path.string().c_str(), "w8"));
+    if(!m_tif)
+        throw std::runtime_error("Could not open " + m_path.string() + " for writing!");
+}
+
+void ome_tiff_writer::write_plane(const cv::Mat &t_image) {
+    if(!m_tif)
+        throw std::logic_error("The OME TIFF " + m_path.string() + " is already closed!");
+    if(m_num_written >= m_plane_layouts.size())
+        throw std::runtime_error("All planes of " + m_path.string() + " were already written!");
+
+    // The IFD must match the OME XML
+    const auto &layout = m_plane_layouts[m_num_written];
+    if(std::get<2>(layout) < 0)
+        throw std::runtime_error("OpenCV does not support the pixel type of " + m_path.string() + "!");
+    if(t_image.rows != std::get<0>(layout) || t_image.cols != std::get<1>(layout) || t_image.type() != std::get<2>(layout)) {
+        throw std::runtime_error("Plane " + std::to_string(m_num_written) + " of " + m_path.string() + " has the size " +
+                                 std::to_string(t_image.cols) + "x" + std::to_string(t_image.rows) + " and OpenCV type " + std::to_string(t_image.type()) +
+                                 ", but the metadata requires " + std::to_string(std::get<1>(layout)) + "x" + std::to_string(std::get<0>(layout)) +
+                                 " and OpenCV type " + std::to_string(std::get<2>(layout)) + "!");
+    }
+
+    if(m_num_written == 0) {
+        TIFFSetField(m_tif.get(), TIFFTAG_IMAGEDESCRIPTION, m_ome_xml.c_str());
+    }
+    ome_tiff_write_image(m_tif.get(), t_image, m_compression, m_tile_size, m_workers.get());
+    if(!TIFFWriteDirectory(m_tif.get()))
+        throw std::runtime_error("Could not write TIFF directory " + std::to_string(m_num_written) + " of " + m_path.string());
+    ++m_num_written;
+}
+
+void ome_tiff_writer::close() {
+    m_tif.reset();
+}
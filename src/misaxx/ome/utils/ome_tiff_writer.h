@@ -0,0 +1,86 @@
+/**
+ * Copyright by Ruman Gerst
+ * Research Group Applied Systems Biology - Head: Prof. Dr. Marc Thilo Figge
+ * https://www.leibniz-hki.de/en/applied-systems-biology.html
+ * HKI-Center for Systems Biology of Infection
+ * Leibniz Institute for Natural Product Research and Infection Biology - Hans Knöll Insitute (HKI)
+ * Adolf-Reichwein-Straße 23, 07745 Jena, Germany
+ *
+ * This code is licensed under BSD 2-Clause
+ * See the LICENSE file provided with this code for the full license.
+ */
+
+
+#pragma once
+
+#include <memory>
+#include <tuple>
+#include <string>
+#include <vector>
+#include <boost/filesystem.hpp>
+#include <opencv2/opencv.hpp>
+#include <ome/files/Types.h>
+#include <ome/xml/meta/OMEXMLMetadata.h>
+#include <tiffio.h>
+#include "ome_tiff_compression.h"
+#include "ome_worker_pool.h"
+
+namespace misaxx::ome {
+
+    /**
+     * Writes a single-file OME TIFF with libtiff.
+     * Unlike the OME Files writer, all compression settings (codec, level and predictor) are applied to the planes.
+     * Planes must be written in the order they are stored within the OME TIFF, which is by series and
+     * then by their plane index within the series. Each plane is stored in its own IFD.
+     * The strips or tiles of each plane can be compressed in parallel, while the IFDs are written in order.
+     * This class is not thread-safe.
+     */
+    class ome_tiff_writer {
+    public:
+
+        /**
+         * Creates the OME TIFF
+         * @param t_path Path of the OME TIFF
+         * @param t_metadata Metadata of the OME TIFF. The TiffData of the written file is created from a copy.
+         * @param t_compression
+         * @param t_tile_size If larger than zero, the planes are stored in square tiles of this size
+         * @param t_workers If set, the strips or tiles of a plane are compressed by the writing thread and this pool
+         */
+        ome_tiff_writer(boost::filesystem::path t_path, const std::shared_ptr<::ome::xml::meta::OMEXMLMetadata> &t_metadata,
+                ome_tiff_compression t_compression, ::ome::files::dimension_size_type t_tile_size,
+                std::shared_ptr<ome_worker_pool> t_workers = nullptr);
+
+        ome_tiff_writer(const ome_tiff_writer &) = delete;
+
+        ome_tiff_writer &operator=(const ome_tiff_writer &) = delete;
+
+        /**
+         * Writes the next plane into its own IFD
+         * @param t_image Must have the size, pixel type and samples per pixel that the metadata defines for the plane
+         */
+        void write_plane(const cv::Mat &t_image);
+
+        /**
+         * Closes the file. The file is only a valid OME TIFF if all planes were written.
+         */
+        void close();
+
+    private:
+        boost::filesystem::path m_path;
+        ome_tiff_compression m_compression;
+        uint32_t m_tile_size = 0;
+        std::shared_ptr<ome_worker_pool> m_workers;
+        std::unique_ptr<TIFF, decltype(&TIFFClose)> m_tif;
+
+        /**
+         * OME XML that is stored in the first IFD
+         */
+        std::string m_ome_xml;
+
+        /**
+         * Rows, columns and OpenCV type of each plane in the order they are written
+         */
+        std::vector<std::tuple<int, int, int>> m_plane_layouts;
+        ::ome::files::dimension_size_type m_num_written = 0;
+    };
+}
@@ -12,6 +12,9 @@
 
 #include "ome_to_opencv.h"
 #include <ome/files/VariantPixelBuffer.h>
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
 
 using namespace misaxx::ome;
 
@@ -24,16 +27,59 @@ namespace {
     * @param size_y
     * @param channels
     * @param opencv_type
-    * @return
+    * @param result the destination. Allocated if it does not have the size and type of the plane.
     */
-    template<typename RawType> inline cv::Mat ome_to_opencv_detail(const ::ome::files::VariantPixelBuffer &ome_buffer, int size_x, int size_y, int channels, int opencv_type) {
-        cv::Mat result(size_y, size_x, opencv_type, cv::Scalar::all(0));
-
-        if(!result.isContinuous())
-            throw std::runtime_error("cv::Mat must be continuous!");
+    template<typename RawType> inline void ome_to_opencv_detail(const ::ome::files::VariantPixelBuffer &ome_buffer, int size_x, int size_y, int channels, int opencv_type, cv::Mat &result) {
+        result.create(size_y, size_x, opencv_type);
 
         const auto &src_array = ome_buffer.array<RawType>();
 
+        // Fast paths for buffers that can be addressed via their strides
+        const auto *strides = src_array.strides();
+        const auto *bases = src_array.index_bases();
+        const bool is_strided = std::all_of(strides, strides + src_array.num_dimensions(), [](auto stride) { return stride > 0; }) &&
+                std::all_of(bases, bases + src_array.num_dimensions(), [](auto base) { return base == 0; });
+
+        if(is_strided) {
+            const RawType *src = src_array.origin();
+            const auto stride_x = strides[::ome::files::DIM_SPATIAL_X];
+            const auto stride_y = strides[::ome::files::DIM_SPATIAL_Y];
+            const auto stride_c = strides[::ome::files::DIM_SUBCHANNEL];
+
+            if((channels == 1 || stride_c == 1) && stride_x == channels && stride_y == static_cast<std::ptrdiff_t>(size_x) * channels) {
+                // Same layout as OpenCV
+                if(result.isContinuous()) {
+                    std::memcpy(result.data, src, result.total() * result.elemSize());
+                }
+                else {
+                    for(int y = 0; y < result.rows; ++y) {
+                        std::memcpy(result.ptr(y), src + y * stride_y, result.cols * result.elemSize());
+                    }
+                }
+            }
+            else if(stride_x == 1 && stride_y == size_x && stride_c == static_cast<std::ptrdiff_t>(size_x) * size_y) {
+                // Planar subchannels: Interleave them
+                std::vector<cv::Mat> planes;
+                for(int c = 0; c < channels; ++c) {
+                    planes.emplace_back(size_y, size_x, CV_MAKETYPE(result.depth(), 1), const_cast<RawType*>(src + c * stride_c));
+                }
+                cv::merge(planes, result);
+            }
+            else {
+                for(int y = 0; y < result.rows; ++y) {
+                    auto *ptr = result.ptr<RawType>(y);
+                    const RawType *src_row = src + y * stride_y;
+                    for(int x = 0; x < result.cols; ++x) {
+                        const RawType *src_pixel = src_row + x * stride_x;
+                        for(int c = 0; c < channels; ++c) {
+                            ptr[x * channels + c] = src_pixel[c * stride_c];
+                        }
+                    }
+                }
+            }
+            return;
+        }
+
         ::ome::files::PixelBufferBase::indices_type idx;
         std::fill(idx.begin(), idx.end(), 0);
 
@@ -48,36 +94,50 @@ namespace {
                 }
             }
         }
-        return result;
     }
 }
 
-cv::Mat misaxx::ome::ome_to_opencv(const ::ome::files::FormatReader &ome_reader, const misa_ome_plane_description &index) {
-
+int misaxx::ome::ome_pixel_type_to_opencv_depth(::ome::xml::model::enums::PixelType pixel_type) {
     using namespace ::ome::xml::model::enums;
+    switch(pixel_type) {
+        case PixelType::UINT8:
+            return CV_8U;
+        case PixelType::INT8:
+            return CV_8S;
+        case PixelType::UINT16:
+            return CV_16U;
+        case PixelType::INT16:
+            return CV_16S;
+        case PixelType::INT32:
+            return CV_32S;
+        case PixelType::FLOAT:
+            return CV_32F;
+        case PixelType::DOUBLE:
+            return CV_64F;
+        default:
+            return -1;
+    }
+}
 
-    int size_x = static_cast<int>(ome_reader.getSizeX());
-    int size_y = static_cast<int>(ome_reader.getSizeY());
-    int channels = static_cast<int>(ome_reader.getRGBChannelCount(index.c));
+void misaxx::ome::ome_to_opencv(const ::ome::files::VariantPixelBuffer &ome_buffer, int size_x, int size_y, int channels, cv::Mat &dst) {
 
-    ::ome::files::VariantPixelBuffer ome_buffer;
-    ome_reader.openBytes(index.index_within(ome_reader), ome_buffer);
+    using namespace ::ome::xml::model::enums;
 
     switch(ome_buffer.pixelType()) {
         case PixelType::UINT8:
-            return ome_to_opencv_detail<uchar>(ome_buffer, size_x, size_y, channels, CV_8UC(channels));
+            return ome_to_opencv_detail<uchar>(ome_buffer, size_x, size_y, channels, CV_8UC(channels), dst);
         case PixelType::INT8:
-            return ome_to_opencv_detail<char>(ome_buffer, size_x, size_y, channels, CV_8SC(channels));
+            return ome_to_opencv_detail<char>(ome_buffer, size_x, size_y, channels, CV_8SC(channels), dst);
         case PixelType::UINT16:
-            return ome_to_opencv_detail<ushort>(ome_buffer, size_x, size_y, channels, CV_16UC(channels));
+            return ome_to_opencv_detail<ushort>(ome_buffer, size_x, size_y, channels, CV_16UC(channels), dst);
         case PixelType::INT16:
-            return ome_to_opencv_detail<short>(ome_buffer, size_x, size_y, channels, CV_16SC(channels));
+            return ome_to_opencv_detail<short>(ome_buffer, size_x, size_y, channels, CV_16SC(channels), dst);
         case PixelType::INT32:
-            return ome_to_opencv_detail<int>(ome_buffer, size_x, size_y, channels, CV_32SC(channels));
+            return ome_to_opencv_detail<int>(ome_buffer, size_x, size_y, channels, CV_32SC(channels), dst);
         case PixelType::FLOAT:
-            return ome_to_opencv_detail<float>(ome_buffer, size_x, size_y, channels, CV_32FC(channels));
+            return ome_to_opencv_detail<float>(ome_buffer, size_x, size_y, channels, CV_32FC(channels), dst);
         case PixelType::DOUBLE:
-            return ome_to_opencv_detail<double>(ome_buffer, size_x, size_y, channels, CV_64FC(channels));
+            return ome_to_opencv_detail<double>(ome_buffer, size_x, size_y, channels, CV_64FC(channels), dst);
         case PixelType::UINT32:
         case PixelType::COMPLEXFLOAT:
         case PixelType::COMPLEXDOUBLE:
@@ -86,3 +146,33 @@ cv::Mat misaxx::ome::ome_to_opencv(const ::ome::files::FormatReader &ome_reader,
             throw std::runtime_error("OpenCV does not support this pixel type!");
     }
 }
+
+cv::Mat misaxx::ome::ome_to_opencv(const ::ome::files::VariantPixelBuffer &ome_buffer, int size_x, int size_y, int channels) {
+    cv::Mat result;
+    ome_to_opencv(ome_buffer, size_x, size_y, channels, result);
+    return result;
+}
+
+cv::Mat misaxx::ome::ome_to_opencv(const ::ome::files::FormatReader &ome_reader, const misa_ome_plane_description &index) {
+    int size_x = static_cast<int>(ome_reader.getSizeX());
+    int size_y = static_cast<int>(ome_reader.getSizeY());
+    int channels = static_cast<int>(ome_reader.getRGBChannelCount(index.c));
+
+    ::ome::files::VariantPixelBuffer ome_buffer;
+    ome_reader.openBytes(index.index_within(ome_reader), ome_buffer);
+    return ome_to_opencv(ome_buffer, size_x, size_y, channels);
+}
+
+cv::Mat misaxx::ome::ome_to_opencv(const ::ome::files::FormatReader &ome_reader, const misa_ome_plane_description &index,
+                                   const cv::Rect &region) {
+    int channels = static_cast<int>(ome_reader.getRGBChannelCount(index.c));
+
+    // Only the strips / tiles that overlap the region are decoded
+    ::ome::files::VariantPixelBuffer ome_buffer;
+    ome_reader.openBytes(index.index_within(ome_reader), ome_buffer,
+            static_cast<::ome::files::dimension_size_type>(region.x),
+            static_cast<::ome::files::dimension_size_type>(region.y),
+            static_cast<::ome::files::dimension_size_type>(region.width),
+            static_cast<::ome::files::dimension_size_type>(region.height));
+    return ome_to_opencv(ome_buffer, region.width, region.height, channels);
+}
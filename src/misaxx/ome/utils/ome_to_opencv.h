@@ -13,6 +13,7 @@
 #pragma once
 
 #include <ome/files/FormatReader.h>
+#include <ome/files/VariantPixelBuffer.h>
 #include <opencv2/opencv.hpp>
 #include <misaxx/ome/descriptions/misa_ome_plane_description.h>
 
@@ -25,4 +26,42 @@ namespace misaxx::ome {
      */
     extern cv::Mat ome_to_opencv(const ::ome::files::FormatReader &ome_reader, const misa_ome_plane_description &index);
 
+    /**
+     * Converts a region of a plane into a cv::Mat
+     * @param ome_reader
+     * @param index
+     * @param region Region within the plane. Must be located within the plane.
+     * @return
+     */
+    extern cv::Mat ome_to_opencv(const ::ome::files::FormatReader &ome_reader, const misa_ome_plane_description &index, const cv::Rect &region);
+
+    /**
+     * Converts a OME variant pixel buffer into a cv::Mat
+     * @param ome_buffer
+     * @param size_x
+     * @param size_y
+     * @param channels
+     * @return
+     */
+    extern cv::Mat ome_to_opencv(const ::ome::files::VariantPixelBuffer &ome_buffer, int size_x, int size_y, int channels);
+
+    /**
+     * Converts a OME variant pixel buffer into an existing cv::Mat.
+     * The destination is only allocated if it does not have the size and type of the plane.
+     * Otherwise the pixels are written into it, which allows the destination to be a view into a larger buffer.
+     * @param ome_buffer
+     * @param size_x
+     * @param size_y
+     * @param channels
+     * @param dst
+     */
+    extern void ome_to_opencv(const ::ome::files::VariantPixelBuffer &ome_buffer, int size_x, int size_y, int channels, cv::Mat &dst);
+
+    /**
+     * Returns the OpenCV depth of an OME pixel type
+     * @param pixel_type
+     * @return -1 if OpenCV does not support the pixel type
+     */
+    extern int ome_pixel_type_to_opencv_depth(::ome::xml::model::enums::PixelType pixel_type);
+
 }
\ No newline at end of file
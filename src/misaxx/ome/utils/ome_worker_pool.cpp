@@ -0,0 +1,68 @@
+/**
+ * Copyright by Ruman Gerst
+ * Research Group Applied Systems Biology - Head: Prof. Dr. Marc Thilo Figge
+ * https://www.leibniz-hki.de/en/applied-systems-biology.html
+ * HKI-Center for Systems Biology of Infection
+ * Leibniz Institute for Natural Product Research and Infection Biology - Hans Knöll Insitute (HKI)
+ * Adolf-Reichwein-Straße 23, 07745 Jena, Germany
+ *
+ * This code is licensed under BSD 2-Clause
+ * See the LICENSE file provided with this code for the full license.
+ */
+
+#include "ome_worker_pool.h"
+
+using namespace misaxx::ome;
+
+ome_worker_pool::ome_worker_pool(size_t t_num_threads) {
+    for(size_t i = 0; i < t_num_threads; ++i) {
+        m_threads.emplace_back([this]() {
+            work();
+        });
+    }
+}
+
+ome_worker_pool::~ome_worker_pool() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_queued.notify_all();
+    for(auto &thread : m_threads) {
+        thread.join();
+    }
+}
+
+size_t ome_worker_pool::get_num_threads() const {
+    return m_threads.size();
+}
+
+void ome_worker_pool::enqueue(std::function<void()> t_task) {
+    if(m_threads.empty()) {
+        t_task();
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_queue.emplace_back(std::move(t_task));
+    }
+    m_queued.notify_one();
+}
+
+void ome_worker_pool::work() {
+    while(true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_queued.wait(lock, [this]() {
+                return m_stopping || !m_queue.empty();
+            });
+            if(m_queue.empty())
+                return;
+            task = std::move(m_queue.front());
+            m_queue.pop_front();
+        }
+        // Exceptions are stored in the future of the task
+        task();
+    }
+}
@@ -0,0 +1,83 @@
+/**
+ * Copyright by Ruman Gerst
+ * Research Group Applied Systems Biology - Head: Prof. Dr. Marc Thilo Figge
+ * https://www.leibniz-hki.de/en/applied-systems-biology.html
+ * HKI-Center for Systems Biology of Infection
+ * Leibniz Institute for Natural Product Research and Infection Biology - Hans Knöll Insitute (HKI)
+ * Adolf-Reichwein-Straße 23, 07745 Jena, Germany
+ *
+ * This code is licensed under BSD 2-Clause
+ * See the LICENSE file provided with this code for the full license.
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace misaxx::ome {
+
+    /**
+     * Fixed number of threads that run queued tasks in the order they were submitted.
+     * The thread that submits tasks is expected to work as well, so a pool for N parallel tasks has N - 1 threads.
+     * Tasks must not wait for other tasks of the same pool, as all threads might be occupied by waiting tasks.
+     * All methods are thread-safe.
+     */
+    class ome_worker_pool {
+    public:
+
+        /**
+         * Starts the threads
+         * @param t_num_threads If zero, tasks are run by the submitting thread
+         */
+        explicit ome_worker_pool(size_t t_num_threads);
+
+        ome_worker_pool(const ome_worker_pool &) = delete;
+
+        ome_worker_pool &operator=(const ome_worker_pool &) = delete;
+
+        /**
+         * Runs the remaining tasks and stops the threads
+         */
+        ~ome_worker_pool();
+
+        /**
+         * Queues a task
+         * @param t_function
+         * @return The result of the task
+         */
+        template<class Function> std::future<std::invoke_result_t<Function>> submit(Function t_function) {
+            using result_type = std::invoke_result_t<Function>;
+            auto task = std::make_shared<std::packaged_task<result_type()>>(std::move(t_function));
+            std::future<result_type> result = task->get_future();
+            enqueue([task]() {
+                (*task)();
+            });
+            return result;
+        }
+
+        /**
+         * Number of threads of this pool
+         * @return
+         */
+        size_t get_num_threads() const;
+
+    private:
+        std::vector<std::thread> m_threads;
+        std::deque<std::function<void()>> m_queue;
+        bool m_stopping = false;
+        std::mutex m_mutex;
+        std::condition_variable m_queued;
+
+        void enqueue(std::function<void()> t_task);
+
+        void work();
+    };
+}
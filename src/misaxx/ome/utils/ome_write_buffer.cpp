@@ -0,0 +1,591 @@
+/**
+ * Copyright by Ruman Gerst
+ * Research Group Applied Systems Biology - Head: Prof. Dr. Marc Thilo Figge
+ * https://www.leibniz-hki.de/en/applied-systems-biology.html
+ * HKI-Center for Systems Biology of Infection
+ * Leibniz Institute for Natural Product Research and Infection Biology - Hans Knöll Insitute (HKI)
+ * Adolf-Reichwein-Straße 23, 07745 Jena, Germany
+ *
+ * This code is licensed under BSD 2-Clause
+ * See the LICENSE file provided with this code for the full license.
+ */
+
+#include "ome_write_buffer.h"
+#include <misaxx/core/utils/string.h>
+#include <misaxx/imaging/utils/tiffio.h>
+#include <boost/crc.hpp>
+#include <tiffio.h>
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+using namespace misaxx::ome;
+
+namespace {
+
+    using tiff_handle = std::unique_ptr<TIFF, decltype(&TIFFClose)>;
+
+    boost::filesystem::path get_write_buffer_directory(const boost::filesystem::path &t_tiff_path) {
+        return t_tiff_path.parent_path() / "__misa_ome_write_buffer__";
+    }
+
+    void create_parent_directory(const boost::filesystem::path &t_path) {
+        if(!boost::filesystem::is_directory(t_path.parent_path())) {
+            boost::filesystem::create_directories(t_path.parent_path());
+        }
+    }
+
+    /**
+     * CRC-32 of the pixel data of an image
+     * @param t_image
+     * @return
+     */
+    uint32_t get_checksum(const cv::Mat &t_image) {
+        boost::crc_32_type crc;
+        const size_t row_bytes = t_image.cols * t_image.elemSize();
+        for(int y = 0; y < t_image.rows; ++y) {
+            crc.process_bytes(t_image.ptr(y), row_bytes);
+        }
+        return crc.checksum();
+    }
+
+    /**
+     * Returns true if the image has the size, type and checksum that are stored in the manifest entry
+     * @param t_image
+     * @param t_entry
+     * @return
+     */
+    bool matches_entry(const cv::Mat &t_image, const nlohmann::json &t_entry) {
+        return t_image.rows == t_entry["rows"].get<int>() && t_image.cols == t_entry["cols"].get<int>() &&
+               t_image.type() == t_entry["opencv-type"].get<int>() &&
+               get_checksum(t_image) == t_entry["checksum"].get<uint32_t>();
+    }
+
+    nlohmann::json create_entry(const cv::Mat &t_image) {
+        nlohmann::json entry;
+        entry["rows"] = t_image.rows;
+        entry["cols"] = t_image.cols;
+        entry["opencv-type"] = t_image.type();
+        entry["checksum"] = get_checksum(t_image);
+        return entry;
+    }
+}
+
+ome_write_buffer_manifest::ome_write_buffer_manifest(boost::filesystem::path t_path, std::string t_dataset) :
+        m_path(std::move(t_path)), m_dataset(std::move(t_dataset)) {
+
+}
+
+void ome_write_buffer_manifest::add(const misa_ome_plane_description &t_location, nlohmann::json t_entry) {
+    t_entry["operation"] = "add";
+    t_entry["location"] = t_location;
+    append(t_entry);
+}
+
+void ome_write_buffer_manifest::remove(const misa_ome_plane_description &t_location) {
+    nlohmann::json record;
+    record["operation"] = "remove";
+    record["location"] = t_location;
+    append(record);
+}
+
+std::vector<nlohmann::json> ome_write_buffer_manifest::load() {
+    std::vector<nlohmann::json> result;
+    if(m_dataset.empty() || !boost::filesystem::is_regular_file(m_path))
+        return result;
+
+    std::ifstream stream(m_path.string());
+    std::string line;
+
+    // The manifest must have been written for the same dataset
+    bool identified = false;
+    if(std::getline(stream, line)) {
+        try {
+            const nlohmann::json record = nlohmann::json::parse(line);
+            identified = record.value("operation", std::string()) == "dataset" && record.value("dataset", std::string()) == m_dataset;
+        }
+        catch(const std::exception &) {
+        }
+    }
+    if(!identified) {
+        std::cout << "[MISA++ OME] Write buffer manifest " << m_path << " belongs to another dataset and is ignored" << "\n";
+        return result;
+    }
+
+    while(std::getline(stream, line)) {
+        try {
+            nlohmann::json record = nlohmann::json::parse(line);
+            if(record.count("operation") > 0 && record.count("location") > 0) {
+                result.emplace_back(std::move(record));
+            }
+        }
+        catch(const std::exception &) {
+            // The last line might be incomplete
+        }
+    }
+    m_continue = true;
+    return result;
+}
+
+void ome_write_buffer_manifest::clear() {
+    if(m_stream.is_open()) {
+        m_stream.close();
+    }
+    boost::filesystem::remove(m_path);
+    m_continue = false;
+}
+
+void ome_write_buffer_manifest::append(const nlohmann::json &t_record) {
+    if(!m_stream.is_open()) {
+        create_parent_directory(m_path);
+        // Records of previous runs are only kept if they were loaded
+        m_stream.open(m_path.string(), m_continue ? std::ios::app : std::ios::trunc);
+        if(!m_stream)
+            throw std::runtime_error("Could not open write buffer manifest " + m_path.string());
+        if(!m_continue) {
+            nlohmann::json header;
+            header["operation"] = "dataset";
+            header["dataset"] = m_dataset;
+            m_stream << header.dump() << "\n";
+            m_continue = true;
+        }
+    }
+    m_stream << t_record.dump() << "\n";
+    m_stream.flush();
+    if(!m_stream)
+        throw std::runtime_error("Could not write into write buffer manifest " + m_path.string());
+}
+
+ome_write_buffer::encoded_plane::encoded_plane(misa_ome_plane_description t_location, ome_write_buffer_format t_format) :
+        location(std::move(t_location)), format(t_format) {
+
+}
+
+void ome_write_buffer::write(const misa_ome_plane_description &t_location, const cv::Mat &t_image,
+                             const ome_tiff_compression &t_compression) {
+    add(encode(t_location, t_image, t_compression));
+}
+
+void ome_write_buffer::read_into(const misa_ome_plane_description &t_location, cv::Mat &t_dst) const {
+    const cv::Mat plane = read(t_location);
+    if(t_dst.empty())
+        t_dst = plane;
+    else
+        plane.copyTo(t_dst);
+}
+
+cv::Mat ome_write_buffer::read_region(const misa_ome_plane_description &t_location, const cv::Rect &t_region) const {
+    return read(t_location)(t_region).clone();
+}
+
+std::unique_ptr<ome_write_buffer>
+ome_write_buffer::create(ome_write_buffer_format t_format, const boost::filesystem::path &t_tiff_path, const std::string &t_dataset) {
+    switch(t_format) {
+        case ome_write_buffer_format::files:
+            return std::make_unique<ome_write_buffer_files>(t_tiff_path, t_dataset);
+        case ome_write_buffer_format::log:
+            return std::make_unique<ome_write_buffer_log>(t_tiff_path, t_dataset);
+        default:
+            throw std::runtime_error("Unsupported write buffer format!");
+    }
+}
+
+ome_write_buffer_format ome_write_buffer::parse_format(const std::string &t_name) {
+    if(t_name == "files")
+        return ome_write_buffer_format::files;
+    if(t_name == "log")
+        return ome_write_buffer_format::log;
+    throw std::runtime_error("Unsupported write buffer format " + t_name + "! Supported are files and log.");
+}
+
+ome_write_buffer_files::ome_write_buffer_files(boost::filesystem::path t_tiff_path, std::string t_dataset) : m_tiff_path(std::move(t_tiff_path)),
+        m_manifest(get_write_buffer_directory(m_tiff_path) / (m_tiff_path.filename().string() + ".files.manifest"), std::move(t_dataset)) {
+
+}
+
+ome_write_buffer_files::encoded_file::~encoded_file() {
+    if(!encoded_path.empty()) {
+        boost::system::error_code error;
+        boost::filesystem::remove(encoded_path, error);
+    }
+}
+
+std::unique_ptr<ome_write_buffer::encoded_plane> ome_write_buffer_files::encode(const misa_ome_plane_description &t_location,
+        const cv::Mat &t_image, const ome_tiff_compression &t_compression) const {
+    // A temporary file prevents readers from seeing a partially written plane
+    const boost::filesystem::path path = get_path(t_location);
+    create_parent_directory(path);
+    auto result = std::make_unique<encoded_file>(t_location, ome_write_buffer_format::files);
+    result->encoded_path = path.parent_path() / boost::filesystem::unique_path(path.filename().string() + ".%%%%-%%%%-%%%%.tmp");
+    ome_tiff_write_compressed(t_image, result->encoded_path, t_compression);
+    result->entry = create_entry(t_image);
+    result->entry["path"] = path.filename().string();
+    result->entry["file-size"] = boost::filesystem::file_size(result->encoded_path);
+    return result;
+}
+
+void ome_write_buffer_files::add(std::unique_ptr<encoded_plane> t_plane) {
+    if(t_plane->format != ome_write_buffer_format::files)
+        throw std::logic_error("The plane was encoded for a write buffer of another format!");
+    auto &plane = static_cast<encoded_file&>(*t_plane);
+    const boost::filesystem::path path = get_path(plane.location);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    boost::filesystem::rename(plane.encoded_path, path);
+    plane.encoded_path.clear();
+    m_planes[plane.location] = path;
+    m_unverified.erase(plane.location);
+    m_manifest.add(plane.location, std::move(plane.entry));
+}
+
+ome_write_buffer_format ome_write_buffer_files::get_format() const {
+    return ome_write_buffer_format::files;
+}
+
+cv::Mat ome_write_buffer_files::read(const misa_ome_plane_description &t_location) const {
+    cv::Mat image = misaxx::imaging::utils::tiffread(find(t_location));
+    verify(t_location, image);
+    return image;
+}
+
+void ome_write_buffer_files::read_into(const misa_ome_plane_description &t_location, cv::Mat &t_dst) const {
+    const boost::filesystem::path path = find(t_location);
+    tiff_handle tif(TIFFOpen(path.string().c_str(), "r"), &TIFFClose);
+    if(!tif)
+        throw std::runtime_error("Could not open write buffer plane " + path.string());
+
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint16_t bits_per_sample = 0;
+    uint16_t samples_per_pixel = 0;
+    uint16_t sample_format = SAMPLEFORMAT_UINT;
+    uint16_t planar_config = PLANARCONFIG_CONTIG;
+    uint32_t rows_per_strip = 0;
+    TIFFGetField(tif.get(), TIFFTAG_IMAGEWIDTH, &width);
+    TIFFGetField(tif.get(), TIFFTAG_IMAGELENGTH, &height);
+    TIFFGetFieldDefaulted(tif.get(), TIFFTAG_BITSPERSAMPLE, &bits_per_sample);
+    TIFFGetFieldDefaulted(tif.get(), TIFFTAG_SAMPLESPERPIXEL, &samples_per_pixel);
+    TIFFGetFieldDefaulted(tif.get(), TIFFTAG_SAMPLEFORMAT, &sample_format);
+    TIFFGetFieldDefaulted(tif.get(), TIFFTAG_PLANARCONFIG, &planar_config);
+    TIFFGetFieldDefaulted(tif.get(), TIFFTAG_ROWSPERSTRIP, &rows_per_strip);
+
+    // encode() writes contiguous strips. Other layouts are decoded into a new image.
+    const int depth = ome_tiff_get_opencv_depth(bits_per_sample, sample_format);
+    if(width == 0 || height == 0 || depth < 0 || samples_per_pixel == 0 || samples_per_pixel > CV_CN_MAX || TIFFIsTiled(tif.get()) ||
+       (planar_config != PLANARCONFIG_CONTIG && samples_per_pixel > 1)) {
+        tif.reset();
+        ome_write_buffer::read_into(t_location, t_dst);
+        return;
+    }
+    rows_per_strip = std::min(std::max<uint32_t>(1, rows_per_strip), height);
+
+    t_dst.create(static_cast<int>(height), static_cast<int>(width), CV_MAKETYPE(depth, samples_per_pixel));
+    const size_t row_bytes = width * t_dst.elemSize();
+    std::vector<uchar> strip;
+    if(!t_dst.isContinuous()) {
+        strip.resize(rows_per_strip * row_bytes);
+    }
+    for(uint32_t y = 0; y < height; y += rows_per_strip) {
+        const uint32_t rows = std::min(rows_per_strip, height - y);
+        // Strips of a destination that is not continuous are decoded into a separate buffer
+        uchar *target = strip.empty() ? t_dst.ptr(static_cast<int>(y)) : strip.data();
+        if(TIFFReadEncodedStrip(tif.get(), TIFFComputeStrip(tif.get(), y, 0), target, static_cast<tmsize_t>(rows * row_bytes)) < 0)
+            throw std::runtime_error("Could not read write buffer plane " + path.string());
+        if(!strip.empty()) {
+            for(uint32_t row = 0; row < rows; ++row) {
+                std::memcpy(t_dst.ptr(static_cast<int>(y + row)), strip.data() + row * row_bytes, row_bytes);
+            }
+        }
+    }
+    verify(t_location, t_dst);
+}
+
+bool ome_write_buffer_files::contains(const misa_ome_plane_description &t_location) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_planes.find(t_location) != m_planes.end();
+}
+
+std::vector<misa_ome_plane_description> ome_write_buffer_files::get_planes() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::vector<misa_ome_plane_description> result;
+    for(const auto &kv : m_planes) {
+        result.push_back(kv.first);
+    }
+    return result;
+}
+
+bool ome_write_buffer_files::empty() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_planes.empty();
+}
+
+void ome_write_buffer_files::remove(const misa_ome_plane_description &t_location) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const auto it = m_planes.find(t_location);
+    if(it != m_planes.end()) {
+        m_removed.push_back(it->second);
+        m_planes.erase(it);
+        m_unverified.erase(t_location);
+        m_manifest.remove(t_location);
+    }
+}
+
+void ome_write_buffer_files::clear(bool remove_data) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if(remove_data) {
+        for(const auto &kv : m_planes) {
+            boost::filesystem::remove(kv.second);
+        }
+        for(const auto &path : m_removed) {
+            boost::filesystem::remove(path);
+        }
+    }
+    m_planes.clear();
+    m_removed.clear();
+    m_unverified.clear();
+    m_manifest.clear();
+}
+
+size_t ome_write_buffer_files::restore(const restore_filter &t_filter) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if(!m_planes.empty())
+        throw std::logic_error("Only empty write buffers can be restored!");
+
+    // Replay the manifest to obtain the last state of each plane
+    std::map<misa_ome_plane_description, nlohmann::json> entries;
+    for(const nlohmann::json &record : m_manifest.load()) {
+        const auto location = record["location"].get<misa_ome_plane_description>();
+        if(record["operation"] == "add") {
+            entries[location] = record;
+        }
+        else {
+            entries.erase(location);
+            m_removed.push_back(get_path(location));
+        }
+    }
+
+    for(const auto &kv : entries) {
+        if(!t_filter(kv.first, kv.second["rows"].get<int>(), kv.second["cols"].get<int>(), kv.second["opencv-type"].get<int>())) {
+            std::cout << "[MISA++ OME] Write buffer plane " << kv.first << " of " << m_tiff_path << " does not match the OME TIFF and is not restored" << "\n";
+            continue;
+        }
+        // Decoding all planes would delay the start of the run, so their checksum is verified when they are read
+        const boost::filesystem::path path = get_write_buffer_directory(m_tiff_path) / kv.second["path"].get<std::string>();
+        boost::system::error_code error;
+        if(boost::filesystem::is_regular_file(path, error) && kv.second.count("file-size") > 0 &&
+           boost::filesystem::file_size(path, error) == kv.second["file-size"].get<uintmax_t>() && !error) {
+            m_planes[kv.first] = path;
+            m_unverified[kv.first] = kv.second;
+            continue;
+        }
+        std::cout << "[MISA++ OME] Write buffer plane " << kv.first << " of " << m_tiff_path << " is damaged and is not restored" << "\n";
+    }
+    return m_planes.size();
+}
+
+boost::filesystem::path ome_write_buffer_files::get_path(const misa_ome_plane_description &t_location) const {
+    return get_write_buffer_directory(m_tiff_path) / (m_tiff_path.filename().string() + "_" + misaxx::utils::to_string(t_location) + ".ome.tif");
+}
+
+void ome_write_buffer_files::verify(const misa_ome_plane_description &t_location, const cv::Mat &t_image) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const auto it = m_unverified.find(t_location);
+    if(it == m_unverified.end())
+        return;
+    if(!matches_entry(t_image, it->second))
+        throw std::runtime_error("The plane " + misaxx::utils::to_string(t_location) + " restored from the write buffer of " + m_tiff_path.string() + " is damaged!");
+    m_unverified.erase(it);
+}
+
+boost::filesystem::path ome_write_buffer_files::find(const misa_ome_plane_description &t_location) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const auto it = m_planes.find(t_location);
+    if(it == m_planes.end())
+        throw std::runtime_error("The plane " + misaxx::utils::to_string(t_location) + " is not in the write buffer!");
+    return it->second;
+}
+
+ome_write_buffer_log::ome_write_buffer_log(const boost::filesystem::path &t_tiff_path, std::string t_dataset) :
+        m_log_path(get_write_buffer_directory(t_tiff_path) / (t_tiff_path.filename().string() + ".planes")),
+        m_manifest(get_write_buffer_directory(t_tiff_path) / (t_tiff_path.filename().string() + ".planes.manifest"), std::move(t_dataset)) {
+
+}
+
+std::unique_ptr<ome_write_buffer::encoded_plane> ome_write_buffer_log::encode(const misa_ome_plane_description &t_location,
+        const cv::Mat &t_image, const ome_tiff_compression &) const {
+    if(t_image.empty())
+        throw std::runtime_error("Trying to write empty image to the write buffer!");
+    auto result = std::make_unique<encoded_rows>(t_location, ome_write_buffer_format::log);
+    result->image = t_image.isContinuous() ? t_image : t_image.clone();
+    result->entry = create_entry(result->image);
+    return result;
+}
+
+void ome_write_buffer_log::add(std::unique_ptr<encoded_plane> t_plane) {
+    if(t_plane->format != ome_write_buffer_format::log)
+        throw std::logic_error("The plane was encoded for a write buffer of another format!");
+    auto &encoded = static_cast<encoded_rows&>(*t_plane);
+    const cv::Mat &image = encoded.image;
+
+    entry plane;
+    plane.rows = image.rows;
+    plane.cols = image.cols;
+    plane.opencv_type = image.type();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if(!m_log.is_open()) {
+        create_parent_directory(m_log_path);
+        m_log_size = boost::filesystem::exists(m_log_path) ? boost::filesystem::file_size(m_log_path) : 0;
+        m_log.open(m_log_path.string(), std::ios::binary | std::ios::app);
+        if(!m_log)
+            throw std::runtime_error("Could not open write buffer " + m_log_path.string());
+    }
+
+    // Readers open the log separately, so the data must be flushed
+    const auto bytes = static_cast<std::streamsize>(image.total() * image.elemSize());
+    m_log.write(reinterpret_cast<const char*>(image.data), bytes);
+    m_log.flush();
+    if(!m_log)
+        throw std::runtime_error("Could not write into write buffer " + m_log_path.string());
+
+    plane.offset = m_log_size;
+    m_log_size += static_cast<uint64_t>(bytes);
+    m_planes[encoded.location] = plane;
+    encoded.entry["offset"] = plane.offset;
+    m_manifest.add(encoded.location, std::move(encoded.entry));
+}
+
+ome_write_buffer_format ome_write_buffer_log::get_format() const {
+    return ome_write_buffer_format::log;
+}
+
+cv::Mat ome_write_buffer_log::read(const misa_ome_plane_description &t_location) const {
+    const entry plane = find(t_location);
+    return read_rows(plane, 0, plane.rows);
+}
+
+void ome_write_buffer_log::read_into(const misa_ome_plane_description &t_location, cv::Mat &t_dst) const {
+    const entry plane = find(t_location);
+    t_dst.create(plane.rows, plane.cols, plane.opencv_type);
+    read_rows(plane, 0, t_dst);
+}
+
+cv::Mat ome_write_buffer_log::read_region(const misa_ome_plane_description &t_location, const cv::Rect &t_region) const {
+    // Only the rows of the region are read
+    const entry plane = find(t_location);
+    cv::Mat rows = read_rows(plane, t_region.y, t_region.height);
+    return rows(cv::Rect(t_region.x, 0, t_region.width, t_region.height)).clone();
+}
+
+bool ome_write_buffer_log::contains(const misa_ome_plane_description &t_location) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_planes.find(t_location) != m_planes.end();
+}
+
+std::vector<misa_ome_plane_description> ome_write_buffer_log::get_planes() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::vector<misa_ome_plane_description> result;
+    for(const auto &kv : m_planes) {
+        result.push_back(kv.first);
+    }
+    return result;
+}
+
+bool ome_write_buffer_log::empty() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_planes.empty();
+}
+
+void ome_write_buffer_log::remove(const misa_ome_plane_description &t_location) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if(m_planes.erase(t_location) > 0) {
+        m_manifest.remove(t_location);
+    }
+}
+
+void ome_write_buffer_log::clear(bool remove_data) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if(m_log.is_open()) {
+        m_log.close();
+    }
+    if(remove_data) {
+        boost::filesystem::remove(m_log_path);
+    }
+    m_planes.clear();
+    m_log_size = 0;
+    m_manifest.clear();
+}
+
+size_t ome_write_buffer_log::restore(const restore_filter &t_filter) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if(!m_planes.empty())
+        throw std::logic_error("Only empty write buffers can be restored!");
+
+    // Replay the manifest to obtain the last state of each plane
+    std::map<misa_ome_plane_description, nlohmann::json> entries;
+    for(const nlohmann::json &record : m_manifest.load()) {
+        const auto location = record["location"].get<misa_ome_plane_description>();
+        if(record["operation"] == "add") {
+            entries[location] = record;
+        }
+        else {
+            entries.erase(location);
+        }
+    }
+
+    // Planes are only restored if their data was completely appended
+    const uint64_t log_size = boost::filesystem::exists(m_log_path) ? boost::filesystem::file_size(m_log_path) : 0;
+    for(const auto &kv : entries) {
+        entry plane;
+        plane.offset = kv.second["offset"].get<uint64_t>();
+        plane.rows = kv.second["rows"].get<int>();
+        plane.cols = kv.second["cols"].get<int>();
+        plane.opencv_type = kv.second["opencv-type"].get<int>();
+        if(!t_filter(kv.first, plane.rows, plane.cols, plane.opencv_type)) {
+            std::cout << "[MISA++ OME] Write buffer plane " << kv.first << " of " << m_log_path << " does not match the OME TIFF and is not restored" << "\n";
+            continue;
+        }
+        const uint64_t plane_bytes = static_cast<uint64_t>(plane.rows) * plane.cols * CV_ELEM_SIZE(plane.opencv_type);
+        try {
+            if(plane.offset + plane_bytes <= log_size && matches_entry(read_rows(plane, 0, plane.rows), kv.second)) {
+                m_planes[kv.first] = plane;
+                continue;
+            }
+        }
+        catch(const std::exception &) {
+        }
+        std::cout << "[MISA++ OME] Write buffer plane " << kv.first << " of " << m_log_path << " is damaged and is not restored" << "\n";
+    }
+    return m_planes.size();
+}
+
+ome_write_buffer_log::entry ome_write_buffer_log::find(const misa_ome_plane_description &t_location) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const auto it = m_planes.find(t_location);
+    if(it == m_planes.end())
+        throw std::runtime_error("The plane " + misaxx::utils::to_string(t_location) + " is not in the write buffer!");
+    return it->second;
+}
+
+cv::Mat ome_write_buffer_log::read_rows(const entry &t_entry, int t_first_row, int t_rows) const {
+    cv::Mat result(t_rows, t_entry.cols, t_entry.opencv_type);
+    read_rows(t_entry, t_first_row, result);
+    return result;
+}
+
+void ome_write_buffer_log::read_rows(const entry &t_entry, int t_first_row, cv::Mat &t_dst) const {
+    const uint64_t row_bytes = static_cast<uint64_t>(t_entry.cols) * t_dst.elemSize();
+
+    std::ifstream log(m_log_path.string(), std::ios::binary);
+    log.seekg(static_cast<std::streamoff>(t_entry.offset + t_first_row * row_bytes));
+    if(t_dst.isContinuous()) {
+        log.read(reinterpret_cast<char*>(t_dst.data), static_cast<std::streamsize>(t_dst.rows * row_bytes));
+    }
+    else {
+        for(int y = 0; y < t_dst.rows; ++y) {
+            log.read(reinterpret_cast<char*>(t_dst.ptr(y)), static_cast<std::streamsize>(row_bytes));
+        }
+    }
+    if(!log)
+        throw std::runtime_error("Could not read from write buffer " + m_log_path.string());
+}
@@ -0,0 +1,385 @@
+/**
+ * Copyright by Ruman Gerst
+ * Research Group Applied Systems Biology - Head: Prof. Dr. Marc Thilo Figge
+ * https://www.leibniz-hki.de/en/applied-systems-biology.html
+ * HKI-Center for Systems Biology of Infection
+ * Leibniz Institute for Natural Product Research and Infection Biology - Hans Knöll Insitute (HKI)
+ * Adolf-Reichwein-Straße 23, 07745 Jena, Germany
+ *
+ * This code is licensed under BSD 2-Clause
+ * See the LICENSE file provided with this code for the full license.
+ */
+
+#pragma once
+
+#include <fstream>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <boost/filesystem.hpp>
+#include <opencv2/opencv.hpp>
+#include <nlohmann/json.hpp>
+#include <misaxx/ome/descriptions/misa_ome_plane_description.h>
+#include "ome_tiff_compression.h"
+
+namespace misaxx::ome {
+
+    /**
+     * Available storage formats of the write buffer
+     */
+    enum class ome_write_buffer_format {
+        /**
+         * Each plane is stored as standard TIFF
+         */
+        files,
+        /**
+         * All planes are appended to one file that contains the raw pixel data
+         */
+        log
+    };
+
+    /**
+     * Append-only record of the planes that are stored in a write buffer.
+     * Each line of the manifest is a JSON object that either adds or removes a plane.
+     * The first line identifies the dataset the planes belong to.
+     * The manifest is flushed after each change, so it survives if the application is interrupted.
+     * This class is not thread-safe.
+     */
+    class ome_write_buffer_manifest {
+    public:
+
+        /**
+         * @param t_path
+         * @param t_dataset Identifies the dataset the planes belong to. If empty, the manifest cannot be loaded.
+         */
+        explicit ome_write_buffer_manifest(boost::filesystem::path t_path, std::string t_dataset);
+
+        /**
+         * Records that a plane was stored. The data of the plane must be completely written before.
+         * @param t_location
+         * @param t_entry Information that is required to restore the plane
+         */
+        void add(const misa_ome_plane_description &t_location, nlohmann::json t_entry);
+
+        /**
+         * Records that a plane was removed
+         * @param t_location
+         */
+        void remove(const misa_ome_plane_description &t_location);
+
+        /**
+         * Loads all records in the order they were added. Further records are appended to the loaded manifest.
+         * Incomplete records (for example a partially written last line) are ignored.
+         * Manifests of another dataset are not loaded and are replaced by the next record.
+         * @return
+         */
+        std::vector<nlohmann::json> load();
+
+        /**
+         * Closes and deletes the manifest
+         */
+        void clear();
+
+    private:
+        boost::filesystem::path m_path;
+        std::string m_dataset;
+        std::ofstream m_stream;
+
+        /**
+         * If true, records are appended to the existing manifest
+         */
+        bool m_continue = false;
+
+        void append(const nlohmann::json &t_record);
+    };
+
+    /**
+     * Stores planes that were written, but are not part of the OME TIFF yet.
+     * The write buffer is located in the __misa_ome_write_buffer__ directory next to the OME TIFF.
+     * A manifest of the stored planes allows the write buffer to be restored by a later run if the OME TIFF
+     * could not be assembled.
+     * All methods are thread-safe.
+     */
+    class ome_write_buffer {
+    public:
+
+        /**
+         * Plane that was encoded by encode(), but is not stored in the buffer yet.
+         * Encoded data that was not added to a buffer is deleted on destruction.
+         */
+        struct encoded_plane {
+            misa_ome_plane_description location;
+            ome_write_buffer_format format;
+
+            encoded_plane(misa_ome_plane_description t_location, ome_write_buffer_format t_format);
+
+            virtual ~encoded_plane() = default;
+        };
+
+        /**
+         * Decides if a plane with the given location, size and OpenCV type can be restored by restore()
+         */
+        using restore_filter = std::function<bool(const misa_ome_plane_description &t_location, int t_rows, int t_cols, int t_opencv_type)>;
+
+        virtual ~ome_write_buffer() = default;
+
+        /**
+         * Stores a plane. Existing data of the plane is replaced.
+         * @param t_location
+         * @param t_image
+         * @param t_compression Compression of the stored data, if supported by the format
+         */
+        void write(const misa_ome_plane_description &t_location, const cv::Mat &t_image, const ome_tiff_compression &t_compression);
+
+        /**
+         * Encodes a plane without storing it. The plane is stored by add().
+         * This allows the encoding to run while the caller does not hold its locks.
+         * @param t_location
+         * @param t_image
+         * @param t_compression Compression of the stored data, if supported by the format
+         * @return
+         */
+        virtual std::unique_ptr<encoded_plane> encode(const misa_ome_plane_description &t_location, const cv::Mat &t_image,
+                const ome_tiff_compression &t_compression) const = 0;
+
+        /**
+         * Stores a plane that was encoded by a buffer of the same format and OME TIFF. Existing data of the plane is replaced.
+         * @param t_plane
+         */
+        virtual void add(std::unique_ptr<encoded_plane> t_plane) = 0;
+
+        /**
+         * The storage format of this buffer
+         * @return
+         */
+        virtual ome_write_buffer_format get_format() const = 0;
+
+        /**
+         * Reads a stored plane
+         * @param t_location
+         * @return
+         */
+        virtual cv::Mat read(const misa_ome_plane_description &t_location) const = 0;
+
+        /**
+         * Reads a stored plane into an existing cv::Mat.
+         * The destination is only allocated if it does not have the size and type of the plane.
+         * @param t_location
+         * @param t_dst
+         */
+        virtual void read_into(const misa_ome_plane_description &t_location, cv::Mat &t_dst) const;
+
+        /**
+         * Reads a region of a stored plane
+         * @param t_location
+         * @param t_region
+         * @return
+         */
+        virtual cv::Mat read_region(const misa_ome_plane_description &t_location, const cv::Rect &t_region) const;
+
+        /**
+         * Returns true if the plane is stored
+         * @param t_location
+         * @return
+         */
+        virtual bool contains(const misa_ome_plane_description &t_location) const = 0;
+
+        /**
+         * Returns all stored planes
+         * @return
+         */
+        virtual std::vector<misa_ome_plane_description> get_planes() const = 0;
+
+        virtual bool empty() const = 0;
+
+        /**
+         * Removes the plane from the buffer. Its data is kept until the buffer is cleared.
+         * @param t_location
+         */
+        virtual void remove(const misa_ome_plane_description &t_location) = 0;
+
+        /**
+         * Removes all planes from the buffer and deletes the manifest
+         * @param remove_data If true, the stored data of all planes (including removed planes) is deleted
+         */
+        virtual void clear(bool remove_data) = 0;
+
+        /**
+         * Loads the planes listed in the manifest of a previous run into the empty buffer.
+         * Only manifests of the same dataset are loaded. Planes whose data is missing or damaged are skipped.
+         * @param t_filter Planes that are rejected by the filter are skipped
+         * @return Number of restored planes
+         */
+        virtual size_t restore(const restore_filter &t_filter) = 0;
+
+        /**
+         * Creates a write buffer for an OME TIFF
+         * @param t_format
+         * @param t_tiff_path Path of the OME TIFF
+         * @param t_dataset Identifies the dataset the planes belong to. If empty, the buffer cannot be restored.
+         * @return
+         */
+        static std::unique_ptr<ome_write_buffer> create(ome_write_buffer_format t_format, const boost::filesystem::path &t_tiff_path,
+                const std::string &t_dataset = std::string());
+
+        /**
+         * Parses a format name (files or log)
+         * @param t_name
+         * @return
+         */
+        static ome_write_buffer_format parse_format(const std::string &t_name);
+    };
+
+    /**
+     * Write buffer that stores each plane as standard TIFF.
+     * The checksum of restored planes is verified when they are read for the first time.
+     */
+    class ome_write_buffer_files : public ome_write_buffer {
+    public:
+
+        explicit ome_write_buffer_files(boost::filesystem::path t_tiff_path, std::string t_dataset = std::string());
+
+        std::unique_ptr<encoded_plane> encode(const misa_ome_plane_description &t_location, const cv::Mat &t_image,
+                const ome_tiff_compression &t_compression) const override;
+
+        void add(std::unique_ptr<encoded_plane> t_plane) override;
+
+        ome_write_buffer_format get_format() const override;
+
+        cv::Mat read(const misa_ome_plane_description &t_location) const override;
+
+        void read_into(const misa_ome_plane_description &t_location, cv::Mat &t_dst) const override;
+
+        bool contains(const misa_ome_plane_description &t_location) const override;
+
+        std::vector<misa_ome_plane_description> get_planes() const override;
+
+        bool empty() const override;
+
+        void remove(const misa_ome_plane_description &t_location) override;
+
+        void clear(bool remove_data) override;
+
+        size_t restore(const restore_filter &t_filter) override;
+
+    private:
+        boost::filesystem::path m_tiff_path;
+        std::map<misa_ome_plane_description, boost::filesystem::path> m_planes;
+        std::vector<boost::filesystem::path> m_removed;
+        ome_write_buffer_manifest m_manifest;
+        mutable std::mutex m_mutex;
+
+        /**
+         * Manifest entries of restored planes that were not read yet
+         */
+        mutable std::map<misa_ome_plane_description, nlohmann::json> m_unverified;
+
+        /**
+         * Plane that was written into a temporary file
+         */
+        struct encoded_file : public encoded_plane {
+            boost::filesystem::path encoded_path;
+            nlohmann::json entry;
+
+            using encoded_plane::encoded_plane;
+
+            ~encoded_file() override;
+        };
+
+        boost::filesystem::path get_path(const misa_ome_plane_description &t_location) const;
+
+        boost::filesystem::path find(const misa_ome_plane_description &t_location) const;
+
+        /**
+         * Throws if the plane was restored and its data does not match the manifest
+         * @param t_location
+         * @param t_image
+         */
+        void verify(const misa_ome_plane_description &t_location, const cv::Mat &t_image) const;
+    };
+
+    /**
+     * Write buffer that appends the raw pixel data of all planes to one file.
+     * Replaced planes are appended again. Their previous data stays in the file until the buffer is cleared.
+     */
+    class ome_write_buffer_log : public ome_write_buffer {
+    public:
+
+        explicit ome_write_buffer_log(const boost::filesystem::path &t_tiff_path, std::string t_dataset = std::string());
+
+        std::unique_ptr<encoded_plane> encode(const misa_ome_plane_description &t_location, const cv::Mat &t_image,
+                const ome_tiff_compression &t_compression) const override;
+
+        void add(std::unique_ptr<encoded_plane> t_plane) override;
+
+        ome_write_buffer_format get_format() const override;
+
+        cv::Mat read(const misa_ome_plane_description &t_location) const override;
+
+        void read_into(const misa_ome_plane_description &t_location, cv::Mat &t_dst) const override;
+
+        cv::Mat read_region(const misa_ome_plane_description &t_location, const cv::Rect &t_region) const override;
+
+        bool contains(const misa_ome_plane_description &t_location) const override;
+
+        std::vector<misa_ome_plane_description> get_planes() const override;
+
+        bool empty() const override;
+
+        void remove(const misa_ome_plane_description &t_location) override;
+
+        void clear(bool remove_data) override;
+
+        size_t restore(const restore_filter &t_filter) override;
+
+    private:
+
+        /**
+         * Location of the data of a plane within the log
+         */
+        struct entry {
+            uint64_t offset = 0;
+            int rows = 0;
+            int cols = 0;
+            int opencv_type = 0;
+        };
+
+        /**
+         * Continuous copy of a plane that is appended to the log
+         */
+        struct encoded_rows : public encoded_plane {
+            cv::Mat image;
+            nlohmann::json entry;
+
+            using encoded_plane::encoded_plane;
+        };
+
+        boost::filesystem::path m_log_path;
+        std::ofstream m_log;
+        uint64_t m_log_size = 0;
+        std::map<misa_ome_plane_description, entry> m_planes;
+        ome_write_buffer_manifest m_manifest;
+        mutable std::mutex m_mutex;
+
+        entry find(const misa_ome_plane_description &t_location) const;
+
+        /**
+         * Reads rows of a plane from the log
+         * @param t_entry
+         * @param t_first_row
+         * @param t_rows
+         * @return
+         */
+        cv::Mat read_rows(const entry &t_entry, int t_first_row, int t_rows) const;
+
+        /**
+         * Reads rows of a plane from the log into an existing cv::Mat
+         * @param t_entry
+         * @param t_first_row
+         * @param t_dst Must have the type of the plane, the width of the plane and one row per read row
+         */
+        void read_rows(const entry &t_entry, int t_first_row, cv::Mat &t_dst) const;
+    };
+}
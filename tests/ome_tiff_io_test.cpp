@@ -0,0 +1,316 @@
+/**
+ * Copyright by Ruman Gerst
+ * Research Group Applied Systems Biology - Head: Prof. Dr. Marc Thilo Figge
+ * https://www.leibniz-hki.de/en/applied-systems-biology.html
+ * HKI-Center for Systems Biology of Infection
+ * Leibniz Institute for Natural Product Research and Infection Biology - Hans Knöll Insitute (HKI)
+ * Adolf-Reichwein-Straße 23, 07745 Jena, Germany
+ *
+ * This code is licensed under BSD 2-Clause
+ * See the LICENSE file provided with this code for the full license.
+ */
+
+/**
+ * Round trip tests of the OME TIFF IO. Planes are written, the OME TIFF is closed and the planes are read again.
+ * Usage: misaxx-imaging-ome-test [--directory work-dir]
+ * Failures are reported to stderr, as the OME TIFF IO logs to stdout. The exit code is the number of failed checks.
+ */
+
+#include <misaxx/ome/misa_ome_tiff_description_builder.h>
+#include <src/misaxx/ome/utils/ome_tiff_io.h>
+#include <src/misaxx/ome/utils/ome_tiff_pyramid.h>
+#include <ome/common/log.h>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace misaxx::ome;
+
+namespace {
+
+    const int plane_width = 97;
+    const int plane_height = 75;
+    const size_t num_planes = 5;
+
+    int num_failures = 0;
+
+    void check(bool t_condition, const std::string &t_message) {
+        if(!t_condition) {
+            std::cerr << "[Test] FAILED: " << t_message << "\n";
+            ++num_failures;
+        }
+    }
+
+    /**
+     * Runs a test and reports exceptions as failures
+     */
+    void run_test(const std::string &t_name, const std::function<void()> &t_test) {
+        std::cerr << "[Test] " << t_name << "\n";
+        try {
+            t_test();
+        }
+        catch(const std::exception &e) {
+            check(false, t_name + " threw " + e.what());
+        }
+    }
+
+    bool equals(const cv::Mat &t_lhs, const cv::Mat &t_rhs) {
+        if(t_lhs.size != t_rhs.size || t_lhs.type() != t_rhs.type())
+            return false;
+        return t_lhs.empty() || cv::norm(t_lhs, t_rhs, cv::NORM_INF) == 0;
+    }
+
+    /**
+     * Creates planes with a smooth random pattern. Each plane has different content.
+     */
+    std::vector<cv::Mat> create_planes(int t_opencv_type, uint64_t t_seed = 1) {
+        std::vector<cv::Mat> result;
+        for(size_t z = 0; z < num_planes; ++z) {
+            cv::Mat plane(plane_height, plane_width, t_opencv_type);
+            cv::RNG rng(t_seed + z);
+            rng.fill(plane, cv::RNG::UNIFORM, 0, CV_MAT_DEPTH(t_opencv_type) == CV_8U ? 255 : 65535);
+            cv::GaussianBlur(plane, plane, cv::Size(3, 3), 0);
+            result.emplace_back(std::move(plane));
+        }
+        return result;
+    }
+
+    std::shared_ptr<::ome::xml::meta::OMEXMLMetadata> create_metadata(int t_opencv_type) {
+        misa_ome_tiff_description_builder builder { misa_ome_tiff_description() };
+        builder.of_size(plane_width, plane_height).of_opencv(t_opencv_type).depth(num_planes);
+        return static_cast<misa_ome_tiff_description>(builder).metadata;
+    }
+
+    misa_ome_plane_description get_location(size_t t_z) {
+        return misa_ome_plane_description(0, t_z, 0, 0);
+    }
+
+    /**
+     * Checks that the OME TIFF contains the planes
+     */
+    void check_planes(const boost::filesystem::path &t_path, const std::vector<cv::Mat> &t_planes, const std::string &t_name) {
+        ome_tiff_io io(t_path);
+        for(size_t z = 0; z < t_planes.size(); ++z) {
+            check(equals(io.read_plane(get_location(z)), t_planes[z]), t_name + ": plane " + std::to_string(z));
+        }
+        io.close();
+    }
+
+    std::string get_codec_name(ome_tiff_codec t_codec) {
+        switch(t_codec) {
+            case ome_tiff_codec::none:
+                return "none";
+            case ome_tiff_codec::lzw:
+                return "lzw";
+            case ome_tiff_codec::deflate:
+                return "deflate";
+            case ome_tiff_codec::zstd:
+                return "zstd";
+            default:
+                return "unknown";
+        }
+    }
+
+    void test_round_trip(const boost::filesystem::path &t_directory, int t_opencv_type, ome_tiff_codec t_codec,
+                         uint32_t t_tile_size, ome_write_buffer_format t_format, bool t_direct_writing) {
+        const std::string name = "round_trip_" + std::to_string(t_opencv_type) + "_" + get_codec_name(t_codec) + "_" +
+                std::to_string(t_tile_size) + "_" + (t_format == ome_write_buffer_format::files ? "files" : "log") +
+                (t_direct_writing ? "_direct" : "");
+        run_test(name, [&]() {
+            const boost::filesystem::path path = t_directory / (name + ".ome.tif");
+            const auto planes = create_planes(t_opencv_type);
+            {
+                ome_tiff_io io(path, create_metadata(t_opencv_type), t_format);
+                io.set_compression(ome_tiff_compression(t_codec));
+                io.set_tile_size(t_tile_size);
+                io.set_direct_writing(t_direct_writing);
+                // Planes are written out of order, so some of them are buffered
+                for(size_t z : { 1, 0, 2, 4, 3 }) {
+                    io.write_plane(planes[z], get_location(z));
+                }
+                io.close();
+            }
+            check_planes(path, planes, name);
+        });
+    }
+
+    void test_patch(const boost::filesystem::path &t_directory) {
+        run_test("patch", [&]() {
+            const boost::filesystem::path path = t_directory / "patch.ome.tif";
+            auto planes = create_planes(CV_16UC1);
+            {
+                ome_tiff_io io(path, create_metadata(CV_16UC1));
+                for(size_t z = 0; z < num_planes; ++z) {
+                    io.write_plane(planes[z], get_location(z));
+                }
+                io.close();
+            }
+            const auto file_size = boost::filesystem::file_size(path);
+
+            // Uncompressed planes of the same size are replaced within the file
+            planes[2] = create_planes(CV_16UC1, 100)[0];
+            {
+                ome_tiff_io io(path);
+                io.write_plane(planes[2], get_location(2));
+                check(equals(io.read_plane(get_location(2)), planes[2]), "patch: modified plane before closing");
+                check(equals(io.read_plane(get_location(3)), planes[3]), "patch: other plane before closing");
+                io.close();
+            }
+            check(boost::filesystem::file_size(path) == file_size, "patch: the OME TIFF was rewritten");
+            check_planes(path, planes, "patch");
+        });
+    }
+
+    void test_restore(const boost::filesystem::path &t_directory, ome_write_buffer_format t_format) {
+        const std::string name = std::string("restore_") + (t_format == ome_write_buffer_format::files ? "files" : "log");
+        run_test(name, [&]() {
+            const boost::filesystem::path path = t_directory / (name + ".ome.tif");
+            const auto metadata = create_metadata(CV_8UC1);
+            const auto planes = create_planes(CV_8UC1);
+
+            // The run is interrupted before the OME TIFF is closed
+            {
+                ome_tiff_io io(path, metadata, t_format);
+                io.write_plane(planes[1], get_location(1));
+                io.write_plane(planes[3], get_location(3));
+            }
+
+            // Planes are not restored for another dataset
+            {
+                ome_tiff_io io(path, create_metadata(CV_16UC1), t_format);
+                check(io.restore_write_buffer() == 0, name + ": restored planes of another dataset");
+            }
+
+            {
+                ome_tiff_io io(path, metadata, t_format);
+                check(!io.is_buffered(get_location(1)), name + ": restored without being requested");
+                check(io.restore_write_buffer() == 2, name + ": number of restored planes");
+                check(io.is_buffered(get_location(1)) && io.is_buffered(get_location(3)), name + ": restored planes are buffered");
+                check(equals(io.read_plane(get_location(3)), planes[3]), name + ": restored plane before closing");
+                for(size_t z : { 0, 2, 4 }) {
+                    io.write_plane(planes[z], get_location(z));
+                }
+                io.close();
+            }
+            check_planes(path, planes, name);
+        });
+    }
+
+    void test_regions_and_volumes(const boost::filesystem::path &t_directory) {
+        run_test("regions_and_volumes", [&]() {
+            const boost::filesystem::path path = t_directory / "regions_and_volumes.ome.tif";
+            const auto planes = create_planes(CV_16UC1);
+
+            // The volume is written as slices without copying them
+            cv::Mat volume;
+            {
+                const int sizes[] = { static_cast<int>(num_planes), plane_height, plane_width };
+                volume.create(3, sizes, CV_16UC1);
+                for(size_t z = 0; z < num_planes; ++z) {
+                    planes[z].copyTo(cv::Mat(plane_height, plane_width, CV_16UC1, volume.ptr(static_cast<int>(z))));
+                }
+                ome_tiff_io io(path, create_metadata(CV_16UC1));
+                io.set_compression(ome_tiff_compression(ome_tiff_codec::deflate));
+                io.set_tile_size(32);
+                io.write_volume(volume, 0, 0, 0);
+                io.close();
+            }
+
+            ome_tiff_io io(path);
+            const cv::Rect region(20, 10, 50, 40);
+            for(size_t z = 0; z < num_planes; ++z) {
+                check(equals(io.read_plane_region(get_location(z), region), planes[z](region)),
+                      "regions_and_volumes: region of plane " + std::to_string(z));
+            }
+
+            // Planes can be read into a region of interest of a larger image
+            cv::Mat canvas(plane_height + 10, plane_width + 10, CV_16UC1, cv::Scalar::all(0));
+            cv::Mat target = canvas(cv::Rect(5, 5, plane_width, plane_height));
+            io.read_plane(get_location(2), target);
+            check(equals(target, planes[2]), "regions_and_volumes: plane read into a region of interest");
+
+            const cv::Mat read_volume = io.read_volume(0, 0, 0);
+            check(read_volume.dims == 3 && read_volume.size[0] == static_cast<int>(num_planes), "regions_and_volumes: volume size");
+            check(equals(read_volume, volume), "regions_and_volumes: volume");
+
+            std::vector<misa_ome_plane_description> locations;
+            for(size_t z : { 4, 0, 3 }) {
+                locations.push_back(get_location(z));
+            }
+            const auto read_planes = io.read_planes(locations);
+            check(read_planes.size() == locations.size(), "regions_and_volumes: number of planes read at once");
+            for(size_t i = 0; i < read_planes.size() && i < locations.size(); ++i) {
+                check(equals(read_planes[i], planes[locations[i].z]), "regions_and_volumes: plane read at once " + std::to_string(i));
+            }
+            io.close();
+        });
+    }
+
+    void test_pyramid(const boost::filesystem::path &t_directory) {
+        run_test("pyramid", [&]() {
+            const boost::filesystem::path path = t_directory / "pyramid.ome.tif";
+            const auto planes = create_planes(CV_8UC3);
+            {
+                ome_tiff_io io(path, create_metadata(CV_8UC3));
+                io.set_compression(ome_tiff_compression(ome_tiff_codec::lzw));
+                io.set_pyramid_levels(2);
+                for(size_t z = 0; z < num_planes; ++z) {
+                    io.write_plane(planes[z], get_location(z));
+                }
+                io.close();
+            }
+            check_planes(path, planes, "pyramid");
+
+            ome_tiff_io io(path);
+            for(size_t z = 0; z < num_planes; ++z) {
+                const cv::Mat level_1 = ome_tiff_downsample(planes[z]);
+                const cv::Mat level_2 = ome_tiff_downsample(level_1);
+                check(equals(io.read_plane_level(get_location(z), 1), level_1), "pyramid: level 1 of plane " + std::to_string(z));
+                check(equals(io.read_plane_level(get_location(z), 2), level_2), "pyramid: level 2 of plane " + std::to_string(z));
+                // Levels that are not stored are computed from the plane
+                check(equals(io.read_plane_level(get_location(z), 3), ome_tiff_downsample(level_2)), "pyramid: level 3 of plane " + std::to_string(z));
+            }
+            io.close();
+        });
+    }
+}
+
+int main(int argc, const char **argv) {
+    boost::filesystem::path directory = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("misaxx-ome-test-%%%%-%%%%");
+    for(int i = 1; i + 1 < argc; i += 2) {
+        const std::string argument = argv[i];
+        if(argument == "--directory")
+            directory = argv[i + 1];
+        else {
+            std::cerr << "Unknown argument " << argument << "\n";
+            return 1;
+        }
+    }
+
+    ::ome::common::setLogLevel(::ome::logging::trivial::warning);
+    boost::filesystem::create_directories(directory);
+
+    for(int opencv_type : { CV_8UC1, CV_16UC1 }) {
+        for(ome_tiff_codec codec : { ome_tiff_codec::none, ome_tiff_codec::lzw, ome_tiff_codec::deflate, ome_tiff_codec::zstd }) {
+            if(!ome_tiff_compression(codec).is_supported())
+                continue;
+            for(uint32_t tile_size : { 0u, 32u }) {
+                for(ome_write_buffer_format format : { ome_write_buffer_format::files, ome_write_buffer_format::log }) {
+                    for(bool direct_writing : { false, true }) {
+                        test_round_trip(directory, opencv_type, codec, tile_size, format, direct_writing);
+                    }
+                }
+            }
+        }
+    }
+    test_patch(directory);
+    test_restore(directory, ome_write_buffer_format::files);
+    test_restore(directory, ome_write_buffer_format::log);
+    test_regions_and_volumes(directory);
+    test_pyramid(directory);
+
+    boost::filesystem::remove_all(directory);
+    std::cerr << "[Test] " << num_failures << " checks failed" << "\n";
+    return num_failures;
+}